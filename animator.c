@@ -0,0 +1,248 @@
+/** ********************************************************************************
+*@file animator.c
+*
+*@date March 9th, 2026
+*
+*@author julio.liriano (julio.liriano@gmail.com)
+*
+*@brief
+********************************************************************************
+
+/* Includes ------------------------------------------------------------------*/
+#include "animator.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Imported variables --------------------------------------------------------*/
+
+/* Imported function prototypes ----------------------------------------------*/
+
+/* Private constants ---------------------------------------------------------*/
+#define NUM_DIGITS 10
+#define NUM_ANIM_POSITIONS 4 // POS1 to POS4
+#define CELL_PIXELS (SPRITE_WIDTH * SPRITE_HEIGHT)
+#define CELL_ROW_MASK ((1U << SPRITE_WIDTH) - 1)
+// A transition lasts until the last step is shown, the first step is shown right at the change
+#define ANIM_DURATION_NSEC ((ANIM_STEPS - 1) * ANIM_FRAME_NSEC)
+/* Private macros ------------------------------------------------------------*/
+#define IS_DIGIT(c) ((c) >= ZERO_CHAR && (c) <= NINE_CHAR)
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    character_t from;
+    character_t to;         // NUM_CHARACTERS until a character is set
+    uint64_t startNsec;
+    bool isAnimating;
+} anim_position_t;
+
+/* Private variables ---------------------------------------------------------*/
+static transition_t activeTransition = TRANSITION_NONE;
+static anim_position_t positions[NUM_ANIM_POSITIONS];
+static uint64_t lastStartNsec = 0;
+
+// Every frame of the active transition, for each (from, to) digit pair
+static uint8_t transitionCells[NUM_DIGITS][NUM_DIGITS][ANIM_STEPS + 1][SPRITE_HEIGHT];
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Computes one frame of a transition between two packed cells.
+ *
+ * @param transition
+ * @param from - Packed cell of the old glyph
+ * @param to - Packed cell of the new glyph
+ * @param step - 0 to ANIM_STEPS
+ * @param cellOut - Packed cell of the frame
+ */
+static void buildTransitionCell(transition_t transition, const uint8_t from[SPRITE_HEIGHT], const uint8_t to[SPRITE_HEIGHT],
+                                uint8_t step, uint8_t cellOut[SPRITE_HEIGHT]);
+
+/**
+ * @brief Gets the animation step to show at tickNsec, or ANIM_STEPS once the transition is over.
+ *
+ */
+static uint8_t getStep(const anim_position_t *position, uint64_t tickNsec);
+
+/* Definitions ---------------------------------------------------------------*/
+static void buildTransitionCell(transition_t transition, const uint8_t from[SPRITE_HEIGHT], const uint8_t to[SPRITE_HEIGHT],
+                                uint8_t step, uint8_t cellOut[SPRITE_HEIGHT])
+{
+    switch(transition) {
+        case TRANSITION_SLIDE: {
+            // Each row is a strip of old glyph, one blank column and new glyph, viewed through the cell
+            uint8_t shift = (uint8_t)((step * (SPRITE_WIDTH + 1) + ANIM_STEPS / 2) / ANIM_STEPS);
+            for(uint8_t i = 0; i < SPRITE_HEIGHT; i++) {
+                uint8_t strip = (uint8_t)(from[i] | (to[i] << (SPRITE_WIDTH + 1)));
+                cellOut[i] = (uint8_t)((strip >> shift) & CELL_ROW_MASK);
+            }
+            break;
+        }
+        case TRANSITION_ROLL: {
+            // Column strip of old glyph, one blank row and new glyph, scrolled up through the cell
+            uint8_t shift = (uint8_t)((step * (SPRITE_HEIGHT + 1) + ANIM_STEPS / 2) / ANIM_STEPS);
+            for(uint8_t i = 0; i < SPRITE_HEIGHT; i++) {
+                uint8_t row = i + shift;
+                if(row < SPRITE_HEIGHT) {
+                    cellOut[i] = from[row];
+                } else if(row == SPRITE_HEIGHT) {
+                    cellOut[i] = 0;
+                } else {
+                    cellOut[i] = to[row - SPRITE_HEIGHT - 1];
+                }
+            }
+            break;
+        }
+        case TRANSITION_FADE: {
+            // Pixel p switches at its rank in a scattered order (7 is coprime with the 15 pixels)
+            uint8_t switched = (uint8_t)((step * CELL_PIXELS + ANIM_STEPS / 2) / ANIM_STEPS);
+            for(uint8_t i = 0; i < SPRITE_HEIGHT; i++) {
+                cellOut[i] = 0;
+                for(uint8_t j = 0; j < SPRITE_WIDTH; j++) {
+                    uint8_t rank = (uint8_t)(((i * SPRITE_WIDTH + j) * 7) % CELL_PIXELS);
+                    const uint8_t *source = rank < switched ? to : from;
+                    cellOut[i] |= (uint8_t)(source[i] & (1U << j));
+                }
+            }
+            break;
+        }
+        default:
+            memcpy(cellOut, step < ANIM_STEPS ? from : to, SPRITE_HEIGHT);
+            break;
+    }
+}
+
+static uint8_t getStep(const anim_position_t *position, uint64_t tickNsec)
+{
+    if(!position->isAnimating || tickNsec >= position->startNsec + ANIM_DURATION_NSEC) {
+        return ANIM_STEPS;
+    }
+    if(tickNsec < position->startNsec) {
+        return 1;
+    }
+    return (uint8_t)((tickNsec - position->startNsec) / ANIM_FRAME_NSEC + 1);
+}
+
+led_matrix_err_t animatorInit(transition_t transition)
+{
+    uint8_t digitCells[NUM_DIGITS][SPRITE_HEIGHT];
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(transition < 0 || transition >= NUM_TRANSITIONS) {
+            printf("Invalid argument: transition=%d\n", transition);
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        for(uint8_t d = 0; d < NUM_DIGITS; d++) {
+            getCharacterCell((character_t)(ZERO_CHAR + d), digitCells[d]);
+        }
+        for(uint8_t from = 0; from < NUM_DIGITS; from++) {
+            for(uint8_t to = 0; to < NUM_DIGITS; to++) {
+                for(uint8_t step = 0; step <= ANIM_STEPS; step++) {
+                    buildTransitionCell(transition, digitCells[from], digitCells[to], step, transitionCells[from][to][step]);
+                }
+            }
+        }
+
+        activeTransition = transition;
+        for(uint8_t i = 0; i < NUM_ANIM_POSITIONS; i++) {
+            positions[i] = (anim_position_t){.from = NUM_CHARACTERS, .to = NUM_CHARACTERS, .startNsec = 0, .isAnimating = false};
+        }
+        lastStartNsec = 0;
+    } while(0);
+    return status;
+}
+
+led_matrix_err_t animatorSetCharacter(char_pos_t position, character_t character, uint64_t tickNsec)
+{
+    anim_position_t *anim = NULL;
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(position < POS1 || position > POS4 || position == COLON || character < 0 || character >= NUM_CHARACTERS) {
+            printf("Invalid argument: character=%d, position=%d\n", character, position);
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        // Digit positions around the colon map onto 0-3
+        anim = &positions[position < COLON ? position : position - 1];
+        if(anim->to == character) {
+            break;
+        }
+
+        // A change in the middle of a transition starts the next one from the glyph it was heading to
+        anim->from = anim->to;
+        anim->to = character;
+        anim->isAnimating = activeTransition != TRANSITION_NONE && IS_DIGIT(anim->from) && IS_DIGIT(character);
+        if(anim->isAnimating) {
+            anim->startNsec = tickNsec;
+            lastStartNsec = tickNsec;
+        }
+    } while(0);
+    return status;
+}
+
+led_matrix_err_t animatorRender(uint64_t tickNsec, matrix_row_t rows[MATRIX_HEIGHT], matrix_row_t coverage[MATRIX_HEIGHT])
+{
+    static const char_pos_t cellPositions[NUM_ANIM_POSITIONS] = {POS1, POS2, POS3, POS4};
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(rows == NULL) {
+            printf("Invalid argument: rows is NULL\n");
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        for(uint8_t i = 0; i < NUM_ANIM_POSITIONS; i++) {
+            anim_position_t *anim = &positions[i];
+            uint8_t step = getStep(anim, tickNsec);
+
+            if(anim->to == NUM_CHARACTERS) {
+                continue;
+            }
+            if(step >= ANIM_STEPS) {
+                anim->isAnimating = false;
+                setCharacterInRows(anim->to, cellPositions[i], rows, coverage);
+            } else {
+                setCellInRows(cellPositions[i], transitionCells[anim->from - ZERO_CHAR][anim->to - ZERO_CHAR][step], rows, coverage);
+            }
+        }
+    } while(0);
+    return status;
+}
+
+bool animatorIsActive(uint64_t tickNsec)
+{
+    for(uint8_t i = 0; i < NUM_ANIM_POSITIONS; i++) {
+        if(getStep(&positions[i], tickNsec) < ANIM_STEPS) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t animatorGetNextFrameNsec(uint64_t tickNsec)
+{
+    if(tickNsec < lastStartNsec) {
+        return lastStartNsec;
+    }
+    return lastStartNsec + ((tickNsec - lastStartNsec) / ANIM_FRAME_NSEC + 1) * ANIM_FRAME_NSEC;
+}
+
+led_matrix_err_t animatorGetTransitionCell(character_t from, character_t to, uint8_t step, uint8_t cellOut[SPRITE_HEIGHT])
+{
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(!IS_DIGIT(from) || !IS_DIGIT(to) || step > ANIM_STEPS || cellOut == NULL) {
+            printf("Invalid argument: from=%d, to=%d, step=%d\n", from, to, step);
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        memcpy(cellOut, transitionCells[from - ZERO_CHAR][to - ZERO_CHAR][step], SPRITE_HEIGHT);
+    } while(0);
+    return status;
+}
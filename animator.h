@@ -0,0 +1,93 @@
+/** ********************************************************************************
+*@file animator.h
+*@date March 9th, 2026
+*@author julio.liriano (julio.liriano@gmail.com)
+*@brief Digit transition animations. When the character at a position changes, the
+*       cell plays a short slide, roll or fade from the old glyph to the new one. The
+*       intermediate frames of every digit pair are computed once, so rendering an
+*       animation frame is a table lookup.
+*
+********************************************************************************** */
+#ifndef __ANIMATOR_H
+#define __ANIMATOR_H
+/* Includes ------------------------------------------------------------------*/
+#include "ledMatrix.h"
+#include <stdint.h>
+#include <stdbool.h>
+/* Exported constants --------------------------------------------------------*/
+#define ANIM_FRAME_RATE 60                                  // Frames per second while animating
+#define ANIM_FRAME_NSEC (1000000000ULL / ANIM_FRAME_RATE)
+#define ANIM_STEPS 18                                       // Frames per transition (300 ms)
+/* Exported macros -----------------------------------------------------------*/
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    TRANSITION_NONE = 0,    // Switch instantly
+    TRANSITION_SLIDE,       // New glyph pushes the old one out to the left
+    TRANSITION_ROLL,        // Old glyph rolls up and the new one comes in from below
+    TRANSITION_FADE,        // Pixels change over from old to new in a dithered order
+    NUM_TRANSITIONS // should always be last
+} transition_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Selects the transition and computes its frames for every digit pair. Forgets the
+ *        characters set so far.
+ *
+ * @param transition
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t animatorInit(transition_t transition);
+
+/**
+ * @brief Sets the character shown at a position. When it differs from the current one and
+ *        both are digits, a transition starts at tickNsec. Other changes are instant, as is
+ *        the first character set at a position.
+ *
+ * @param position - POS1 to POS4
+ * @param character
+ * @param tickNsec - Time of the change (getTickNsec() timeline).
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t animatorSetCharacter(char_pos_t position, character_t character, uint64_t tickNsec);
+
+/**
+ * @brief Draws the characters of all positions, as they appear at tickNsec, into a packed frame.
+ *
+ * @param tickNsec - Time of the frame (getTickNsec() timeline).
+ * @param rows - Packed frame to draw into.
+ * @param coverage - Optional (may be NULL). The bits of the drawn cells are set.
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t animatorRender(uint64_t tickNsec, matrix_row_t rows[MATRIX_HEIGHT], matrix_row_t coverage[MATRIX_HEIGHT]);
+
+/**
+ * @brief Returns true while any position is still in a transition at tickNsec.
+ *
+ * @param tickNsec
+ * @return bool
+ */
+bool animatorIsActive(uint64_t tickNsec);
+
+/**
+ * @brief Returns the first animation frame deadline after tickNsec. Frames are on a grid of
+ *        ANIM_FRAME_NSEC from the start of the latest transition.
+ *
+ * @param tickNsec
+ * @return uint64_t - Deadline on the getTickNsec() timeline.
+ */
+uint64_t animatorGetNextFrameNsec(uint64_t tickNsec);
+
+/**
+ * @brief Gets an intermediate frame of a transition between two digits.
+ *
+ * @param from - ZERO_CHAR to NINE_CHAR
+ * @param to - ZERO_CHAR to NINE_CHAR
+ * @param step - 0 (from) to ANIM_STEPS (to)
+ * @param cellOut - SPRITE_HEIGHT packed cell rows.
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t animatorGetTransitionCell(character_t from, character_t to, uint8_t step, uint8_t cellOut[SPRITE_HEIGHT]);
+#endif /* __ANIMATOR_H */
@@ -0,0 +1,425 @@
+/** ********************************************************************************
+*@file bench_main.c
+*
+*@date February 6th, 2026
+*
+*@author julio.liriano (julio.liriano@gmail.com)
+*
+*@brief - Small micro-benchmarks for the clock. Measures the cost per call of 
+*         each tick clock source, of the output transform, of trace events, of 
+*         world clock lookups, of the palette conversion and of LED wear accounting.
+********************************************************************************
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "timeFuncs.h"
+#include "matrixTransform.h"
+#include "trace.h"
+#include "worldClock.h"
+#include "palette.h"
+#include "ledWear.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Imported variables --------------------------------------------------------*/
+
+/* Imported function prototypes ----------------------------------------------*/
+
+/* Private constants ---------------------------------------------------------*/
+#define CLOCK_BENCH_ITERATIONS 10000000ULL
+#define TRANSFORM_BENCH_ITERATIONS 200000ULL
+#define TRACE_BENCH_ITERATIONS 10000000ULL
+#define WORLD_BENCH_ZONES 400 // Zones loaded for the world clock benchmark
+#define WORLD_BENCH_ITERATIONS 1000000ULL
+#define PALETTE_BENCH_ITERATIONS 20000ULL
+#define WEAR_BENCH_ITERATIONS 1000000ULL
+#define WEAR_BENCH_PATH "/tmp/matrixclock_wear_bench.bin"
+/* Private macros ------------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+
+/* Private variables ---------------------------------------------------------*/
+static const char *tickSourceNames[NUM_TICK_SOURCES] = {
+    [TICK_SOURCE_PRECISE] = "CLOCK_MONOTONIC",
+    [TICK_SOURCE_COARSE] = "CLOCK_MONOTONIC_COARSE"
+};
+
+// Sink for benchmark results so the compiler cannot drop the calls.
+static volatile uint64_t benchSink = 0;
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Measures the average cost of reading each tick clock source.
+ * 
+ */
+static void benchClockSources(void);
+
+/**
+ * @brief Measures the cost of transforming one frame with the packed kernels against 
+ *        remapping it pixel by pixel.
+ * 
+ */
+static void benchTransform(void);
+
+/**
+ * @brief Measures the cost of a begin/end trace pair with tracing off and on.
+ * 
+ */
+static void benchTrace(void);
+
+/**
+ * @brief Loads a few hundred zones and compares a world clock lookup with switching TZ 
+ *        and calling localtime_r().
+ * 
+ */
+static void benchWorldClock(void);
+
+/**
+ * @brief Measures converting a frame to the panel color format eight pixels at a time against 
+ *        looking up each pixel on its own, and the cost of a color frame over a monochrome one.
+ * 
+ */
+static void benchPalette(void);
+
+/**
+ * @brief Measures accounting the on-time of a frame with the bit sliced counters against adding 
+ *        to a counter per LED, at one tick per frame and at an accelerated 3600 ticks per frame.
+ * 
+ */
+static void benchWear(void);
+
+/* Definitions ---------------------------------------------------------------*/
+static void benchClockSources(void)
+{
+    printf("Clock source cost (%llu calls each):\n", (unsigned long long)CLOCK_BENCH_ITERATIONS);
+
+    for(int source = 0; source < NUM_TICK_SOURCES; source++) {
+        uint64_t acc = 0;
+        uint64_t start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+        for(uint64_t i = 0; i < CLOCK_BENCH_ITERATIONS; i++) {
+            acc += getMonotonicNsec((tick_source_t)source);
+        }
+        uint64_t elapsed = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+        benchSink = acc;
+
+        printf("  %-32s %6.2f ns/call\n", tickSourceNames[source], (double)elapsed / CLOCK_BENCH_ITERATIONS);
+    }
+
+    // getTick() adds the start offset and msec conversion on top of the raw read
+    for(int source = 0; source < NUM_TICK_SOURCES; source++) {
+        uint64_t acc = 0;
+        setTickSource((tick_source_t)source);
+        uint64_t start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+        for(uint64_t i = 0; i < CLOCK_BENCH_ITERATIONS; i++) {
+            acc += getTick();
+        }
+        uint64_t elapsed = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+        benchSink = acc;
+        printf("  getTick() %-22s %6.2f ns/call\n", tickSourceNames[source], (double)elapsed / CLOCK_BENCH_ITERATIONS);
+    }
+    setTickSource(TICK_SOURCE_PRECISE);
+}
+
+static void benchTransform(void)
+{
+    static output_frame_t out;
+    static const output_transform_t transforms[] = {
+        {ROTATE_0, false, false, 1},
+        {ROTATE_90, false, false, 1},
+        {ROTATE_180, true, false, 1},
+        {ROTATE_270, false, true, 4},
+        {ROTATE_90, true, true, TRANSFORM_MAX_SCALE}
+    };
+    matrix_row_t rows[MATRIX_HEIGHT];
+
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        rows[i] = (0x5A5A5u * (i + 1)) & MATRIX_ROW_ALL;
+    }
+
+    printf("Output transform cost (%llu frames each):\n", (unsigned long long)TRANSFORM_BENCH_ITERATIONS);
+    for(size_t t = 0; t < sizeof(transforms) / sizeof(transforms[0]); t++) {
+        const output_transform_t *transform = &transforms[t];
+        bool isRotated = (transform->rotation == ROTATE_90 || transform->rotation == ROTATE_270);
+        uint16_t scale = transform->scale;
+        setOutputTransform(transform);
+
+        uint64_t start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+        for(uint64_t n = 0; n < TRANSFORM_BENCH_ITERATIONS; n++) {
+            rows[0] ^= 1;
+            transformFrame(rows, &out);
+        }
+        uint64_t packedNsec = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+        benchSink = out.rows[0][0];
+
+        // Naive version: remap every LED and write every output pixel on its own
+        start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+        for(uint64_t n = 0; n < TRANSFORM_BENCH_ITERATIONS; n++) {
+            rows[0] ^= 1;
+            memset(out.rows, 0, sizeof(out.rows));
+            for(uint16_t y = 0; y < MATRIX_HEIGHT; y++) {
+                for(uint16_t x = 0; x < MATRIX_WIDTH; x++) {
+                    uint16_t mx = transform->isMirrorH ? MATRIX_WIDTH - 1 - x : x;
+                    uint16_t my = transform->isMirrorV ? MATRIX_HEIGHT - 1 - y : y;
+                    uint16_t ox = mx, oy = my;
+                    if(transform->rotation == ROTATE_90) {
+                        ox = MATRIX_HEIGHT - 1 - my; oy = mx;
+                    } else if(transform->rotation == ROTATE_180) {
+                        ox = MATRIX_WIDTH - 1 - mx; oy = MATRIX_HEIGHT - 1 - my;
+                    } else if(transform->rotation == ROTATE_270) {
+                        ox = my; oy = MATRIX_WIDTH - 1 - mx;
+                    }
+                    uint64_t bit = (rows[y] >> x) & 1;
+                    for(uint16_t k = 0; k < scale * scale; k++) {
+                        uint16_t px = ox * scale + k % scale;
+                        uint16_t py = oy * scale + k / scale;
+                        out.rows[py][px / 64] |= bit << (px % 64);
+                    }
+                }
+            }
+        }
+        uint64_t naiveNsec = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+        benchSink = out.rows[0][0];
+
+        printf("  rotate %3d mirror %s scale %d (%3dx%3d) %8.1f ns/frame packed, %8.1f ns/frame per-pixel\n",
+               transform->rotation * 90, 
+               transform->isMirrorH ? (transform->isMirrorV ? "hv" : "h ") : (transform->isMirrorV ? " v" : "--"),
+               scale, (isRotated ? MATRIX_HEIGHT : MATRIX_WIDTH) * scale, (isRotated ? MATRIX_WIDTH : MATRIX_HEIGHT) * scale,
+               (double)packedNsec / TRANSFORM_BENCH_ITERATIONS, (double)naiveNsec / TRANSFORM_BENCH_ITERATIONS);
+    }
+
+    output_transform_t identity = {ROTATE_0, false, false, 1};
+    setOutputTransform(&identity);
+}
+
+static void benchTrace(void)
+{
+    printf("Trace event cost (%llu begin/end pairs each):\n", (unsigned long long)TRACE_BENCH_ITERATIONS);
+
+    for(int isEnabled = 0; isEnabled <= 1; isEnabled++) {
+        traceSetEnabled(isEnabled != 0);
+        uint64_t start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+        for(uint64_t i = 0; i < TRACE_BENCH_ITERATIONS; i++) {
+            TRACE_BEGIN("bench");
+            benchSink = i;
+            TRACE_END("bench");
+        }
+        uint64_t elapsed = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+        printf("  tracing %-3s %6.2f ns/pair\n", isEnabled ? "on" : "off", (double)elapsed / TRACE_BENCH_ITERATIONS);
+    }
+    traceSetEnabled(false);
+    traceReset();
+}
+
+static void benchWorldClock(void)
+{
+    static const char *const cities[] = {
+        "America/New_York", "America/Chicago", "America/Denver", "America/Los_Angeles", "Europe/London",
+        "Europe/Paris", "Europe/Berlin", "Asia/Tokyo", "Asia/Kolkata", "Australia/Sydney",
+        "Australia/Lord_Howe", "Pacific/Auckland", "America/Sao_Paulo", "Africa/Cairo", "Asia/Kathmandu", "UTC"
+    };
+    static char zoneList[WORLD_BENCH_ZONES * 32];
+    size_t len = 0;
+    time_t now = time(NULL);
+    uint64_t acc = 0;
+    world_time_t worldTime;
+    struct tm local;
+
+    // The same zones over and over, enough to see how lookups and loading scale
+    for(uint32_t i = 0; i < WORLD_BENCH_ZONES; i++) {
+        len += snprintf(zoneList + len, sizeof(zoneList) - len, "%s%s", i == 0 ? "" : ",", cities[i % (sizeof(cities) / sizeof(cities[0]))]);
+    }
+    uint64_t start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+    if(worldClockLoadZones(zoneList) != LED_OK) {
+        return;
+    }
+    uint64_t loadNsec = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+    printf("World clock (%u zones, %u tables, loaded in %.1f ms):\n", worldClockGetZoneCount(), worldClockGetTableCount(),
+           (double)loadNsec / NSEC_PER_MSEC);
+
+    start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+    for(uint64_t i = 0; i < WORLD_BENCH_ITERATIONS; i++) {
+        worldClockGetTime((uint16_t)(i % WORLD_BENCH_ZONES), now + (time_t)i, &worldTime);
+        acc += worldTime.minute;
+    }
+    uint64_t elapsed = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+    benchSink = acc;
+    printf("  worldClockGetTime()           %8.2f ns/call\n", (double)elapsed / WORLD_BENCH_ITERATIONS);
+
+    // What a frame would do without the tables. Fewer iterations, it is much slower.
+    start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+    for(uint64_t i = 0; i < WORLD_BENCH_ITERATIONS / 100; i++) {
+        time_t t = now + (time_t)i;
+        setenv("TZ", worldClockGetZoneName((uint16_t)(i % WORLD_BENCH_ZONES)), 1);
+        tzset();
+        localtime_r(&t, &local);
+        acc += (uint64_t)local.tm_min;
+    }
+    elapsed = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+    benchSink = acc;
+    printf("  setenv(TZ) + localtime_r()    %8.2f ns/call\n", (double)elapsed / (WORLD_BENCH_ITERATIONS / 100));
+
+    unsetenv("TZ");
+    tzset();
+    worldClockClear();
+}
+
+static void benchPalette(void)
+{
+    static output_frame_t lit;
+    static output_frame_t planes[COLOR_BITS];
+    static uint8_t pixels[PANEL_BUFFER_SIZE];
+    static const uint8_t scales[] = {1, TRANSFORM_MAX_SCALE};
+    matrix_row_t rows[MATRIX_HEIGHT];
+    matrix_row_t colors[COLOR_BITS][MATRIX_HEIGHT];
+
+    // Roughly a clock face: a third of the LEDs lit, in every palette entry
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        rows[i] = (0x5A5A5u * (i + 1)) & MATRIX_ROW_ALL;
+        for(uint8_t b = 0; b < COLOR_BITS; b++) {
+            colors[b][i] = (0x33333u >> (b + i)) & MATRIX_ROW_ALL;
+        }
+    }
+
+    printf("Palette conversion cost (%llu frames each):\n", (unsigned long long)PALETTE_BENCH_ITERATIONS);
+    for(size_t s = 0; s < sizeof(scales); s++) {
+        output_transform_t transform = {ROTATE_0, false, false, scales[s]};
+        setOutputTransform(&transform);
+
+        for(int format = 0; format < NUM_COLOR_FORMATS; format++) {
+            uint8_t bytesPerPixel = paletteGetBytesPerPixel((color_format_t)format);
+            paletteSetOutputFormat((color_format_t)format);
+            transformFrame(rows, &lit);
+            for(uint8_t b = 0; b < COLOR_BITS; b++) {
+                transformFrame(colors[b], &planes[b]);
+            }
+
+            uint64_t start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+            for(uint64_t n = 0; n < PALETTE_BENCH_ITERATIONS; n++) {
+                lit.rows[0][0] ^= 1;
+                benchSink += paletteConvertFrame(&lit, planes, NULL, pixels);
+            }
+            uint64_t packedNsec = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+
+            // Naive version: gather the index bits of each pixel and look it up on its own
+            start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+            for(uint64_t n = 0; n < PALETTE_BENCH_ITERATIONS; n++) {
+                uint8_t *pixel = pixels;
+                lit.rows[0][0] ^= 1;
+                for(uint16_t y = 0; y < lit.height; y++) {
+                    for(uint16_t x = 0; x < lit.width; x++, pixel += bytesPerPixel) {
+                        rgb_color_t color = {0};
+                        if(getOutputPixel(&lit, x, y)) {
+                            color_index_t index = 0;
+                            for(uint8_t b = 0; b < COLOR_BITS; b++) {
+                                index |= (color_index_t)(getOutputPixel(&planes[b], x, y) << b);
+                            }
+                            color = paletteGetColor(index);
+                        }
+                        if(format == COLOR_FORMAT_RGB565) {
+                            uint16_t rgb565 = (uint16_t)(((color.r >> 3) << 11) | ((color.g >> 2) << 5) | (color.b >> 3));
+                            pixel[0] = (uint8_t)(rgb565 >> 8);
+                            pixel[1] = (uint8_t)rgb565;
+                        } else {
+                            pixel[0] = color.r;
+                            pixel[1] = color.g;
+                            pixel[2] = color.b;
+                        }
+                    }
+                }
+            }
+            uint64_t naiveNsec = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+            benchSink += pixels[0];
+
+            printf("  %s %3dx%3d %9.1f ns/frame packed, %9.1f ns/frame per-pixel\n",
+                   format == COLOR_FORMAT_RGB565 ? "RGB565" : "RGB888", lit.width, lit.height,
+                   (double)packedNsec / PALETTE_BENCH_ITERATIONS, (double)naiveNsec / PALETTE_BENCH_ITERATIONS);
+        }
+
+        // What sendMatrix() does per frame: transform only, against transform, planes and conversion
+        uint64_t start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+        for(uint64_t n = 0; n < PALETTE_BENCH_ITERATIONS; n++) {
+            rows[0] ^= 1;
+            transformFrame(rows, &lit);
+        }
+        uint64_t monoNsec = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+        start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+        for(uint64_t n = 0; n < PALETTE_BENCH_ITERATIONS; n++) {
+            rows[0] ^= 1;
+            transformFrame(rows, &lit);
+            for(uint8_t b = 0; b < COLOR_BITS; b++) {
+                transformFrame(colors[b], &planes[b]);
+            }
+            benchSink += paletteConvertFrame(&lit, planes, NULL, pixels);
+        }
+        uint64_t colorNsec = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+        printf("  send scale %d: %9.1f ns/frame monochrome, %9.1f ns/frame with %d bit color\n", scales[s],
+               (double)monoNsec / PALETTE_BENCH_ITERATIONS, (double)colorNsec / PALETTE_BENCH_ITERATIONS, COLOR_BITS);
+    }
+
+    output_transform_t identity = {ROTATE_0, false, false, 1};
+    setOutputTransform(&identity);
+    paletteSetOutputFormat(COLOR_FORMAT_RGB565);
+}
+
+static void benchWear(void)
+{
+    static const uint64_t ticksPerFrame[] = {1, 3600};
+    static uint64_t counts[MATRIX_HEIGHT][MATRIX_WIDTH];
+    matrix_row_t rows[MATRIX_HEIGHT];
+    wear_stats_t stats = {0};
+
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        rows[i] = (0x5A5A5u * (i + 1)) & MATRIX_ROW_ALL;
+    }
+
+    printf("LED wear accounting cost (%llu frames each):\n", (unsigned long long)WEAR_BENCH_ITERATIONS);
+    for(size_t t = 0; t < sizeof(ticksPerFrame) / sizeof(ticksPerFrame[0]); t++) {
+        uint64_t tickStepNsec = ticksPerFrame[t] * WEAR_TICK_MS * NSEC_PER_MSEC;
+
+        unlink(WEAR_BENCH_PATH);
+        if(wearOpen(WEAR_BENCH_PATH) != LED_OK) {
+            return;
+        }
+        uint64_t start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+        for(uint64_t n = 0; n < WEAR_BENCH_ITERATIONS; n++) {
+            rows[0] ^= 1;
+            wearRecordFrame(rows, n * tickStepNsec);
+        }
+        uint64_t slicedNsec = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+        wearGetStats(&stats);
+        wearClose(WEAR_BENCH_ITERATIONS * tickStepNsec);
+        unlink(WEAR_BENCH_PATH);
+
+        // Naive version: a 64 bit counter per LED, added to for each lit LED
+        memset(counts, 0, sizeof(counts));
+        start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+        for(uint64_t n = 0; n < WEAR_BENCH_ITERATIONS; n++) {
+            rows[0] ^= 1;
+            for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+                for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+                    counts[i][j] += ((rows[i] >> j) & 1U) ? ticksPerFrame[t] : 0;
+                }
+            }
+            benchSink += counts[n % MATRIX_HEIGHT][0];
+        }
+        uint64_t naiveNsec = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+
+        printf("  %4llu ticks/frame: %7.1f ns/frame bit sliced (%llu flushes, max %.1f us), %7.1f ns/frame per-LED\n",
+               (unsigned long long)ticksPerFrame[t], (double)slicedNsec / WEAR_BENCH_ITERATIONS, (unsigned long long)stats.flushes,
+               (double)stats.maxFlushNsec / 1000, (double)naiveNsec / WEAR_BENCH_ITERATIONS);
+    }
+}
+
+int main(void) {
+    initTick();
+    benchClockSources();
+    benchTransform();
+    benchTrace();
+    benchWorldClock();
+    benchPalette();
+    benchWear();
+    return 0;
+}
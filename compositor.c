@@ -0,0 +1,343 @@
+/** ********************************************************************************
+*@file compositor.c
+*
+*@date February 16th, 2026
+*
+*@author julio.liriano (julio.liriano@gmail.com)
+*
+*@brief
+********************************************************************************
+
+/* Includes ------------------------------------------------------------------*/
+#include "compositor.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Imported variables --------------------------------------------------------*/
+
+/* Imported function prototypes ----------------------------------------------*/
+
+/* Private constants ---------------------------------------------------------*/
+
+/* Private macros ------------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    matrix_row_t rows[MATRIX_HEIGHT];       // Pixels being drawn
+    matrix_row_t coverage[MATRIX_HEIGHT];   // Cells the layer has drawn into
+} layer_frame_t;
+
+typedef struct {
+    layer_frame_t pending;      // Drawing target, becomes active on the next composite
+    layer_frame_t active;       // Content used in the last composite
+    bool isVisible;
+    blend_mode_t blendMode;
+    color_index_t color;        // Palette index of the pixels the layer lights
+    bool isDirty;               // Visibility, blend mode or color changed since the last composite
+} layer_t;
+
+/* Private variables ---------------------------------------------------------*/
+static layer_t layers[NUM_LAYERS];
+
+// Layer ids from bottom to top
+static layer_id_t zOrder[NUM_LAYERS];
+
+// Result of blending everything up to and including the layer at each z
+static matrix_row_t blendCache[NUM_LAYERS][MATRIX_HEIGHT];
+
+// Palette index planes of the lit pixels of each blendCache entry
+static matrix_row_t colorCache[NUM_LAYERS][COLOR_BITS][MATRIX_HEIGHT];
+
+// Everything below this z has to be blended again (NUM_LAYERS when the cache is valid)
+static uint8_t firstInvalidZ = 0;
+
+static uint8_t lastBlendCount = 0;
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Checks the layer id. Prints the reason if invalid.
+ * 
+ * @param layer 
+ * @return led_matrix_err_t - LED_OK if valid, LED_ARG_ERROR otherwise.
+ */
+static led_matrix_err_t checkLayer(layer_id_t layer);
+
+/**
+ * @brief Returns the z of a layer.
+ * 
+ * @param layer 
+ * @return uint8_t - z-order position
+ */
+static uint8_t getZ(layer_id_t layer);
+
+/**
+ * @brief Blends a layer onto the given rows and their colors. Lit pixels the layer draws take 
+ *        its color, unlit pixels of the result have index 0.
+ * 
+ * @param layer - Layer to blend
+ * @param below - Rows below the layer
+ * @param belowColors - Color planes below the layer
+ * @param out - Blended result
+ * @param outColors - Blended color planes
+ */
+static void blendLayer(const layer_t *layer, const matrix_row_t below[MATRIX_HEIGHT], const matrix_row_t belowColors[COLOR_BITS][MATRIX_HEIGHT],
+                       matrix_row_t out[MATRIX_HEIGHT], matrix_row_t outColors[COLOR_BITS][MATRIX_HEIGHT]);
+
+/**
+ * @brief Commits the pending drawing and blends the layers from the lowest changed one up.
+ * 
+ * @return true - Something changed, the top of the blend cache holds the new frame.
+ * @return false - Nothing changed.
+ */
+static bool blendLayers(void);
+
+/* Definitions ---------------------------------------------------------------*/
+static uint8_t getZ(layer_id_t layer)
+{
+    for(uint8_t z = 0; z < NUM_LAYERS; z++) {
+        if(zOrder[z] == layer) {
+            return z;
+        }
+    }
+    return 0;
+}
+
+static led_matrix_err_t checkLayer(layer_id_t layer)
+{
+    if(layer < 0 || layer >= NUM_LAYERS) {
+        printf("Invalid argument: layer=%d\n", layer);
+        return LED_ARG_ERROR;
+    }
+    return LED_OK;
+}
+
+static void blendLayer(const layer_t *layer, const matrix_row_t below[MATRIX_HEIGHT], const matrix_row_t belowColors[COLOR_BITS][MATRIX_HEIGHT],
+                       matrix_row_t out[MATRIX_HEIGHT], matrix_row_t outColors[COLOR_BITS][MATRIX_HEIGHT])
+{
+    const matrix_row_t *rows = layer->active.rows;
+    const matrix_row_t *coverage = layer->active.coverage;
+
+    if(!layer->isVisible) {
+        memcpy(out, below, sizeof(matrix_row_t) * MATRIX_HEIGHT);
+        memcpy(outColors, belowColors, sizeof(matrix_row_t) * COLOR_BITS * MATRIX_HEIGHT);
+        return;
+    }
+
+    switch(layer->blendMode) {
+        case BLEND_OR:
+            for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+                out[i] = below[i] | (rows[i] & coverage[i]);
+            }
+            break;
+        case BLEND_MASK:
+            for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+                out[i] = below[i] & (rows[i] | ~coverage[i]);
+            }
+            break;
+        case BLEND_REPLACE:
+            for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+                out[i] = (below[i] & ~coverage[i]) | (rows[i] & coverage[i]);
+            }
+            break;
+        default:
+            memcpy(out, below, sizeof(matrix_row_t) * MATRIX_HEIGHT);
+            break;
+    }
+
+    // Pixels drawn by the layer take its color. A mask only removes pixels, the rest keep theirs.
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        matrix_row_t painted = (layer->blendMode == BLEND_MASK) ? 0 : (rows[i] & coverage[i]);
+        for(uint8_t b = 0; b < COLOR_BITS; b++) {
+            matrix_row_t layerBit = ((layer->color >> b) & 1U) ? painted : 0;
+            outColors[b][i] = ((belowColors[b][i] & ~painted) | layerBit) & out[i];
+        }
+    }
+}
+
+void compositorInit(void)
+{
+    memset(layers, 0, sizeof(layers));
+    for(uint8_t i = 0; i < NUM_LAYERS; i++) {
+        zOrder[i] = (layer_id_t)i;
+        layers[i].isVisible = true;
+        layers[i].blendMode = BLEND_OR;
+    }
+    layers[LAYER_OVERLAY].blendMode = BLEND_REPLACE;
+    firstInvalidZ = 0;
+    lastBlendCount = 0;
+}
+
+led_matrix_err_t layerClear(layer_id_t layer)
+{
+    if(checkLayer(layer) != LED_OK) {
+        return LED_ARG_ERROR;
+    }
+    memset(&layers[layer].pending, 0, sizeof(layer_frame_t));
+    return LED_OK;
+}
+
+led_matrix_err_t layerFill(layer_id_t layer, bool isOn)
+{
+    if(checkLayer(layer) != LED_OK) {
+        return LED_ARG_ERROR;
+    }
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        layers[layer].pending.rows[i] = isOn ? MATRIX_ROW_ALL : 0;
+        layers[layer].pending.coverage[i] = MATRIX_ROW_ALL;
+    }
+    return LED_OK;
+}
+
+led_matrix_err_t layerSetCharacter(layer_id_t layer, character_t character, char_pos_t position)
+{
+    if(checkLayer(layer) != LED_OK) {
+        return LED_ARG_ERROR;
+    }
+    return setCharacterInRows(character, position, layers[layer].pending.rows, layers[layer].pending.coverage);
+}
+
+led_matrix_err_t layerSetRows(layer_id_t layer, const matrix_row_t rows[MATRIX_HEIGHT], const matrix_row_t coverage[MATRIX_HEIGHT])
+{
+    if(checkLayer(layer) != LED_OK || rows == NULL) {
+        return LED_ARG_ERROR;
+    }
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        layers[layer].pending.rows[i] = rows[i] & MATRIX_ROW_ALL;
+        layers[layer].pending.coverage[i] = (coverage != NULL) ? (coverage[i] & MATRIX_ROW_ALL) : MATRIX_ROW_ALL;
+    }
+    return LED_OK;
+}
+
+led_matrix_err_t layerSetVisible(layer_id_t layer, bool isVisible)
+{
+    if(checkLayer(layer) != LED_OK) {
+        return LED_ARG_ERROR;
+    }
+    if(layers[layer].isVisible != isVisible) {
+        layers[layer].isVisible = isVisible;
+        layers[layer].isDirty = true;
+    }
+    return LED_OK;
+}
+
+led_matrix_err_t layerSetBlendMode(layer_id_t layer, blend_mode_t mode)
+{
+    if(checkLayer(layer) != LED_OK || mode < 0 || mode >= NUM_BLEND_MODES) {
+        printf("Invalid argument: blend mode=%d\n", mode);
+        return LED_ARG_ERROR;
+    }
+    if(layers[layer].blendMode != mode) {
+        layers[layer].blendMode = mode;
+        layers[layer].isDirty = true;
+    }
+    return LED_OK;
+}
+
+led_matrix_err_t layerSetColor(layer_id_t layer, color_index_t color)
+{
+    if(checkLayer(layer) != LED_OK || color >= PALETTE_SIZE) {
+        printf("Invalid argument: color=%d\n", color);
+        return LED_ARG_ERROR;
+    }
+    if(layers[layer].color != color) {
+        layers[layer].color = color;
+        layers[layer].isDirty = true;
+    }
+    return LED_OK;
+}
+
+led_matrix_err_t layerSetZOrder(layer_id_t layer, uint8_t z)
+{
+    uint8_t oldZ = 0;
+
+    if(checkLayer(layer) != LED_OK || z >= NUM_LAYERS) {
+        printf("Invalid argument: z=%d\n", z);
+        return LED_ARG_ERROR;
+    }
+
+    // Shift the layers in between by one and drop the layer into its new place
+    oldZ = getZ(layer);
+    if(z > oldZ) {
+        memmove(&zOrder[oldZ], &zOrder[oldZ + 1], (z - oldZ) * sizeof(layer_id_t));
+    } else if(z < oldZ) {
+        memmove(&zOrder[z + 1], &zOrder[z], (oldZ - z) * sizeof(layer_id_t));
+    } else {
+        return LED_OK;
+    }
+    zOrder[z] = layer;
+
+    // Everything from the lower of the two positions up has a different stack below it
+    uint8_t lowestZ = z < oldZ ? z : oldZ;
+    if(lowestZ < firstInvalidZ) {
+        firstInvalidZ = lowestZ;
+    }
+    return LED_OK;
+}
+
+static bool blendLayers(void)
+{
+    static const matrix_row_t emptyRows[MATRIX_HEIGHT] = {0};
+    static const matrix_row_t emptyColors[COLOR_BITS][MATRIX_HEIGHT] = {0};
+    uint8_t startZ = firstInvalidZ;
+
+    // Commit drawing done since the last composite. A layer redrawn with the same content is not a change.
+    for(uint8_t z = 0; z < NUM_LAYERS; z++) {
+        layer_t *layer = &layers[zOrder[z]];
+        if(memcmp(&layer->pending, &layer->active, sizeof(layer_frame_t)) != 0) {
+            memcpy(&layer->active, &layer->pending, sizeof(layer_frame_t));
+            layer->isDirty = true;
+        }
+        if(layer->isDirty && z < startZ) {
+            startZ = z;
+        }
+        layer->isDirty = false;
+    }
+
+    lastBlendCount = 0;
+    if(startZ >= NUM_LAYERS) {
+        return false;
+    }
+
+    for(uint8_t z = startZ; z < NUM_LAYERS; z++) {
+        blendLayer(&layers[zOrder[z]], z == 0 ? emptyRows : blendCache[z - 1], z == 0 ? emptyColors : colorCache[z - 1],
+                   blendCache[z], colorCache[z]);
+        lastBlendCount++;
+    }
+    firstInvalidZ = NUM_LAYERS;
+    return true;
+}
+
+led_matrix_err_t compositeLayers(void)
+{
+    if(blendLayers()) {
+        setMatrixRows(blendCache[NUM_LAYERS - 1]);
+        setMatrixColors(colorCache[NUM_LAYERS - 1]);
+    }
+    // Otherwise nothing changed, the LED matrix already holds the result
+    return LED_OK;
+}
+
+led_matrix_err_t compositeLayersToRows(matrix_row_t rowsOut[MATRIX_HEIGHT], matrix_row_t colorsOut[COLOR_BITS][MATRIX_HEIGHT])
+{
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(rowsOut == NULL) {
+            printf("Invalid argument: rowsOut is NULL\n");
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        blendLayers();
+        memcpy(rowsOut, blendCache[NUM_LAYERS - 1], sizeof(blendCache[NUM_LAYERS - 1]));
+        if(colorsOut != NULL) {
+            memcpy(colorsOut, colorCache[NUM_LAYERS - 1], sizeof(colorCache[NUM_LAYERS - 1]));
+        }
+    } while(0);
+    return status;
+}
+
+uint8_t compositorGetBlendCount(void)
+{
+    return lastBlendCount;
+}
@@ -0,0 +1,150 @@
+/** ********************************************************************************
+*@file compositor.h
+*@date February 16th, 2026
+*@author julio.liriano (julio.liriano@gmail.com)
+*@brief Layered compositor. Each display element draws into its own layer and the 
+*       layers are blended, in z-order, into the LED matrix frame.
+*
+********************************************************************************** */
+#ifndef __COMPOSITOR_H
+#define __COMPOSITOR_H
+/* Includes ------------------------------------------------------------------*/
+#include "ledMatrix.h"
+#include <stdint.h>
+#include <stdbool.h>
+/* Exported constants --------------------------------------------------------*/
+
+/* Exported macros -----------------------------------------------------------*/
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    LAYER_BACKGROUND = 0,
+    LAYER_TIME,
+    LAYER_STATUS,       // Status indicators, e.g. the alarm dot
+    LAYER_OVERLAY,      // Notifications and full screen modes drawn over the clock
+    NUM_LAYERS // should always be last
+} layer_id_t;
+
+// How a layer is blended onto the layers below it. Only pixels inside the layer's 
+// coverage (the cells it drew into) are affected.
+typedef enum {
+    BLEND_OR = 0,       // Lit pixels of the layer are added
+    BLEND_MASK,         // Only pixels lit in both the layer and below stay lit
+    BLEND_REPLACE,      // Layer pixels replace what is below
+    NUM_BLEND_MODES // should always be last
+} blend_mode_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Resets all layers to empty and visible with the default z-order (layer id order), 
+ *        blend modes (OR, except the overlay which replaces) and color (palette index 0).
+ * 
+ */
+void compositorInit(void);
+
+/**
+ * @brief Clears a layer. The layer no longer covers any pixels.
+ * 
+ * @param layer 
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t layerClear(layer_id_t layer);
+
+/**
+ * @brief Sets every pixel of a layer and makes it cover the whole frame. 
+ *        E.g. an unlit, replacing overlay blanks out everything below it.
+ * 
+ * @param layer 
+ * @param isOn - Whether the pixels are lit
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t layerFill(layer_id_t layer, bool isOn);
+
+/**
+ * @brief Draws a character into a layer. Same rules as setCharacterAtPosition().
+ * 
+ * @param layer 
+ * @param character 
+ * @param position 
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t layerSetCharacter(layer_id_t layer, character_t character, char_pos_t position);
+
+/**
+ * @brief Replaces a layer's content with a packed frame.
+ * 
+ * @param layer 
+ * @param rows - Packed pixel rows
+ * @param coverage - Packed coverage rows, NULL covers the whole frame
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t layerSetRows(layer_id_t layer, const matrix_row_t rows[MATRIX_HEIGHT], const matrix_row_t coverage[MATRIX_HEIGHT]);
+
+/**
+ * @brief Shows or hides a layer.
+ * 
+ * @param layer 
+ * @param isVisible 
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t layerSetVisible(layer_id_t layer, bool isVisible);
+
+/**
+ * @brief Sets how a layer is blended onto the layers below it.
+ * 
+ * @param layer 
+ * @param mode 
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t layerSetBlendMode(layer_id_t layer, blend_mode_t mode);
+
+/**
+ * @brief Sets the palette index of the pixels a layer lights. The default is 0.
+ * 
+ * @param layer 
+ * @param color - 0 to PALETTE_SIZE - 1
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t layerSetColor(layer_id_t layer, color_index_t color);
+
+/**
+ * @brief Moves a layer to a new place in the z-order. Z 0 is the bottom.
+ * 
+ * @param layer 
+ * @param z - New z-order position (0 to NUM_LAYERS - 1)
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t layerSetZOrder(layer_id_t layer, uint8_t z);
+
+/**
+ * @brief Blends the layers into the LED matrix frame and its colors. The result below each layer is cached, 
+ *        so only the lowest changed layer and those above it are blended again. Does nothing 
+ *        if no layer changed.
+ * 
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t compositeLayers(void);
+
+/**
+ * @brief Blends the layers like compositeLayers() but writes the result to rowsOut instead of the 
+ *        LED matrix, e.g. to render a frame ahead of time. The LED matrix must be set to this frame 
+ *        (setMatrixRows() and setMatrixColors()) before the next compositeLayers(), which only writes it on changes.
+ * 
+ * @param rowsOut - Blended frame, MATRIX_HEIGHT rows.
+ * @param colorsOut - Optional (may be NULL). Palette index planes of the blended frame.
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t compositeLayersToRows(matrix_row_t rowsOut[MATRIX_HEIGHT], matrix_row_t colorsOut[COLOR_BITS][MATRIX_HEIGHT]);
+
+/**
+ * @brief Returns how many layers were blended by the last call to compositeLayers() or compositeLayersToRows().
+ * 
+ * @return uint8_t - Number of layers (0 if nothing changed).
+ */
+uint8_t compositorGetBlendCount(void);
+#endif /* __COMPOSITOR_H */
+
+
+
@@ -0,0 +1,521 @@
+/** ********************************************************************************
+*@file controlServer.c
+*
+*@date February 19th, 2026
+*
+*@author julio.liriano (julio.liriano@gmail.com)
+*
+*@brief
+********************************************************************************
+
+/* Includes ------------------------------------------------------------------*/
+#define _GNU_SOURCE // For accept4()
+#include "controlServer.h"
+#include <stdio.h>
+#include <string.h>
+
+// The server is built on epoll and eventfd, so it only runs on Linux
+#if defined(__linux__)
+    #include <errno.h>
+    #include <pthread.h>
+    #include <stdatomic.h>
+    #include <unistd.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+#endif
+
+/* Imported variables --------------------------------------------------------*/
+
+/* Imported function prototypes ----------------------------------------------*/
+
+/* Private constants ---------------------------------------------------------*/
+#define CTRL_RX_BUFFER_SIZE 8192    // Per client receive buffer, many commands are handled per read
+#define CTRL_TX_BUFFER_SIZE 1024    // Per client reply buffer
+#define CTRL_MAX_EVENTS 64          // epoll events handled per wakeup
+#define CTRL_LISTEN_BACKLOG 16
+#define CTRL_FRAME_SIZE (MATRIX_HEIGHT * sizeof(matrix_row_t))
+/* Private macros ------------------------------------------------------------*/
+
+#if defined(__linux__)
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    int fd;                         // -1 when the slot is free
+    bool isWaitingToWrite;          // Reply buffer full, stopped reading until it drains
+    size_t rxLen;
+    size_t txLen;
+    // Word aligned so pushed frames can be handed out in place
+    union {
+        uint8_t bytes[CTRL_RX_BUFFER_SIZE];
+        matrix_row_t align;
+    } rx;
+    uint8_t tx[CTRL_TX_BUFFER_SIZE];
+} ctrl_client_t;
+
+typedef struct {
+    pthread_t thread;
+    atomic_bool isRunning;
+    int listenFd;
+    int epollFd;
+    int wakeFd;                     // eventfd used to wake the server thread up to stop
+    char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    ctrl_handlers_t handlers;
+    ctrl_stats_t stats;
+    ctrl_client_t clients[CTRL_MAX_CLIENTS];
+} ctrl_server_t;
+
+/* Private variables ---------------------------------------------------------*/
+static ctrl_server_t server = {.listenFd = -1, .epollFd = -1, .wakeFd = -1};
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Server thread. Waits on epoll and handles everything that is ready per wakeup.
+ * 
+ * @param ptr - Unused
+ * @return void* 
+ */
+static void *control_thread(void *ptr);
+
+/**
+ * @brief Accepts all pending connections.
+ * 
+ */
+static void acceptClients(void);
+
+/**
+ * @brief Disconnects a client and frees its slot.
+ * 
+ * @param client 
+ */
+static void closeClient(ctrl_client_t *client);
+
+/**
+ * @brief Reads everything available from a client and handles all complete commands, sending 
+ *        replies as they fill up the reply buffer.
+ * 
+ * @param client 
+ */
+static void readClient(ctrl_client_t *client);
+
+/**
+ * @brief Handles all complete commands in a client's receive buffer.
+ * 
+ * @param client 
+ * @return true - Client is still connected
+ * @return false - Client was disconnected for a protocol error
+ */
+static bool processCommands(ctrl_client_t *client);
+
+/**
+ * @brief Queues a reply to a client. The caller checks there is room.
+ * 
+ * @param client 
+ * @param opcode - Reply opcode
+ * @param payload - Reply payload
+ * @param length - Payload length
+ */
+static void queueReply(ctrl_client_t *client, uint8_t opcode, const void *payload, uint16_t length);
+
+/**
+ * @brief Sends queued replies. Switches the client between waiting for input and waiting 
+ *        to write, depending on whether everything could be sent.
+ * 
+ * @param client 
+ * @return true - Client is still connected
+ * @return false - Client was disconnected
+ */
+static bool flushClient(ctrl_client_t *client);
+
+/* Definitions ---------------------------------------------------------------*/
+static void closeClient(ctrl_client_t *client)
+{
+    epoll_ctl(server.epollFd, EPOLL_CTL_DEL, client->fd, NULL);
+    close(client->fd);
+    client->fd = -1;
+    server.stats.clients--;
+}
+
+static void acceptClients(void)
+{
+    while(true) {
+        int fd = accept4(server.listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd < 0) {
+            return; // EAGAIN, no more pending connections
+        }
+
+        ctrl_client_t *client = NULL;
+        for(uint32_t i = 0; i < CTRL_MAX_CLIENTS; i++) {
+            if(server.clients[i].fd < 0) {
+                client = &server.clients[i];
+                break;
+            }
+        }
+        if(client == NULL) {
+            close(fd); // Full
+            continue;
+        }
+
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = client};
+        client->fd = fd;
+        client->rxLen = 0;
+        client->txLen = 0;
+        client->isWaitingToWrite = false;
+        epoll_ctl(server.epollFd, EPOLL_CTL_ADD, fd, &event);
+        server.stats.clients++;
+    }
+}
+
+static void queueReply(ctrl_client_t *client, uint8_t opcode, const void *payload, uint16_t length)
+{
+    ctrl_header_t header = {.opcode = opcode, .reserved = 0, .length = length};
+    memcpy(&client->tx[client->txLen], &header, CTRL_HEADER_SIZE);
+    memcpy(&client->tx[client->txLen + CTRL_HEADER_SIZE], payload, length);
+    client->txLen += CTRL_HEADER_SIZE + length;
+}
+
+static bool flushClient(ctrl_client_t *client)
+{
+    bool isBlocked = false;
+
+    if(client->txLen > 0) {
+        ssize_t sent = send(client->fd, client->tx, client->txLen, MSG_NOSIGNAL);
+        if(sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            closeClient(client);
+            return false;
+        }
+        if(sent > 0) {
+            memmove(client->tx, client->tx + sent, client->txLen - (size_t)sent);
+            client->txLen -= (size_t)sent;
+        }
+        isBlocked = client->txLen > 0;
+    }
+
+    // Stop reading from a client that does not read its replies until they drain
+    if(isBlocked != client->isWaitingToWrite) {
+        struct epoll_event event = {.events = isBlocked ? EPOLLOUT : EPOLLIN, .data.ptr = client};
+        epoll_ctl(server.epollFd, EPOLL_CTL_MOD, client->fd, &event);
+        client->isWaitingToWrite = isBlocked;
+    }
+    return true;
+}
+
+static bool processCommands(ctrl_client_t *client)
+{
+    const matrix_row_t *pendingFrame = NULL;
+    size_t offset = 0;
+
+    while(client->rxLen - offset >= CTRL_HEADER_SIZE) {
+        ctrl_header_t header;
+        led_matrix_err_t status = LED_OK;
+        const uint8_t *payload = &client->rx.bytes[offset + CTRL_HEADER_SIZE];
+
+        memcpy(&header, &client->rx.bytes[offset], CTRL_HEADER_SIZE);
+        if(header.length > CTRL_MAX_PAYLOAD || (header.length % 4) != 0) {
+            // Can't find the next message boundary, drop the client
+            server.stats.errors++;
+            closeClient(client);
+            return false;
+        }
+        if(client->rxLen - offset < (size_t)CTRL_HEADER_SIZE + header.length) {
+            break; // Rest of the message has not arrived yet
+        }
+        // Leave room for a reply, otherwise wait for the client to read
+        if(client->txLen + 2 * (CTRL_HEADER_SIZE + sizeof(ctrl_state_t)) > CTRL_TX_BUFFER_SIZE) {
+            break;
+        }
+
+        // Frames only need to be shown once they are the newest. Keep a pointer to the latest one 
+        // and hand it over before any other command so the order seen by the handlers is kept.
+        if(header.opcode == CTRL_CMD_PUSH_FRAME && header.length == CTRL_FRAME_SIZE) {
+            if(pendingFrame != NULL) {
+                server.stats.framesCoalesced++;
+            }
+            pendingFrame = (const matrix_row_t *)payload;
+            server.stats.framesPushed++;
+            server.stats.commands++;
+            offset += CTRL_HEADER_SIZE + header.length;
+            continue;
+        }
+        if(pendingFrame != NULL) {
+            server.handlers.pushFrame(pendingFrame);
+            pendingFrame = NULL;
+        }
+
+        switch(header.opcode) {
+            case CTRL_CMD_SET_ALARM:
+                if(header.length == sizeof(ctrl_alarm_t)) {
+                    ctrl_alarm_t alarm;
+                    memcpy(&alarm, payload, sizeof(alarm));
+                    status = server.handlers.setAlarm(true, alarm.hour, alarm.minute);
+                } else {
+                    status = LED_ARG_ERROR;
+                }
+                break;
+            case CTRL_CMD_CLEAR_ALARM:
+                status = server.handlers.setAlarm(false, 0, 0);
+                break;
+            case CTRL_CMD_SET_MODE:
+                if(header.length == sizeof(ctrl_mode_t)) {
+                    status = server.handlers.setMode(payload[0]);
+                } else {
+                    status = LED_ARG_ERROR;
+                }
+                break;
+            case CTRL_CMD_QUERY_STATE: {
+                ctrl_state_t state = {0};
+                server.handlers.getState(&state);
+                queueReply(client, CTRL_RSP_STATE, &state, sizeof(state));
+                break;
+            }
+            default:
+                // Unknown opcode, or a frame of the wrong size
+                status = LED_ARG_ERROR;
+                break;
+        }
+
+        if(status != LED_OK) {
+            ctrl_error_t error = {.opcode = header.opcode, .status = (int8_t)status};
+            queueReply(client, CTRL_RSP_ERROR, &error, sizeof(error));
+            server.stats.errors++;
+        }
+        server.stats.commands++;
+        offset += CTRL_HEADER_SIZE + header.length;
+    }
+
+    // Hand over the frame before the buffer is compacted
+    if(pendingFrame != NULL) {
+        server.handlers.pushFrame(pendingFrame);
+    }
+
+    // Move the incomplete message (if any) to the front. Offsets stay 4 byte aligned.
+    if(offset > 0) {
+        memmove(client->rx.bytes, &client->rx.bytes[offset], client->rxLen - offset);
+        client->rxLen -= offset;
+    }
+    return true;
+}
+
+static void readClient(ctrl_client_t *client)
+{
+    while(client->rxLen < CTRL_RX_BUFFER_SIZE) {
+        ssize_t received = recv(client->fd, &client->rx.bytes[client->rxLen], CTRL_RX_BUFFER_SIZE - client->rxLen, 0);
+        if(received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            closeClient(client);
+            return;
+        }
+        if(received < 0) {
+            break; // Nothing more to read right now
+        }
+        client->rxLen += (size_t)received;
+
+        size_t rxLenBefore = client->rxLen;
+        if(!processCommands(client)) {
+            return;
+        }
+        if(client->rxLen == rxLenBefore && client->rxLen == CTRL_RX_BUFFER_SIZE) {
+            break; // Waiting on the reply buffer to drain
+        }
+    }
+
+    // A full reply buffer stops processCommands with complete commands still buffered (e.g. pipelined
+    // queries). Keep sending and handling them while the socket takes the replies, once it stops 
+    // taking them EPOLLOUT picks up from here.
+    while(flushClient(client) && !client->isWaitingToWrite) {
+        size_t rxLenBefore = client->rxLen;
+        if(!processCommands(client) || client->rxLen == rxLenBefore) {
+            break;
+        }
+    }
+}
+
+static void *control_thread(void *ptr)
+{
+    struct epoll_event events[CTRL_MAX_EVENTS];
+    (void)ptr;
+
+    while(server.isRunning) {
+        int numEvents = epoll_wait(server.epollFd, events, CTRL_MAX_EVENTS, -1);
+        if(numEvents < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        server.stats.wakeups++;
+
+        for(int i = 0; i < numEvents; i++) {
+            if(events[i].data.ptr == &server.listenFd) {
+                acceptClients();
+            } else if(events[i].data.ptr == &server.wakeFd) {
+                // Stop requested, isRunning is already false
+            } else {
+                ctrl_client_t *client = events[i].data.ptr;
+                if(client->fd < 0) {
+                    continue; // Closed earlier in this batch
+                }
+                if(events[i].events & EPOLLOUT) {
+                    // Replies drained, pick up the commands that were waiting on them
+                    if(flushClient(client) && !client->isWaitingToWrite && processCommands(client)) {
+                        readClient(client);
+                    }
+                } else {
+                    readClient(client);
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+led_matrix_err_t controlServerStart(const char *path, const ctrl_handlers_t *handlers)
+{
+    led_matrix_err_t status = LED_OK;
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    struct epoll_event event = {.events = EPOLLIN};
+    struct stat info;
+
+    if (server.isRunning)
+    {
+        return LED_BUSY;
+    }
+
+    do
+    {
+        //Check for valid arguments
+        if (path == NULL || handlers == NULL || handlers->setAlarm == NULL || handlers->setMode == NULL ||
+            handlers->getState == NULL || handlers->pushFrame == NULL || strlen(path) >= sizeof(addr.sun_path))
+        {
+            printf("Invalid argument: control socket path or handlers\n");
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        memset(&server.stats, 0, sizeof(server.stats));
+        for (uint32_t i = 0; i < CTRL_MAX_CLIENTS; i++)
+        {
+            server.clients[i].fd = -1;
+        }
+        server.handlers = *handlers;
+        strcpy(server.path, path);
+        strcpy(addr.sun_path, path);
+
+        server.listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        server.epollFd = epoll_create1(EPOLL_CLOEXEC);
+        server.wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (server.listenFd < 0 || server.epollFd < 0 || server.wakeFd < 0)
+        {
+            status = LED_IO_ERROR;
+            break;
+        }
+
+        // Only a socket left behind by an earlier run is replaced, never whatever else the path names
+        if (lstat(path, &info) == 0)
+        {
+            if (!S_ISSOCK(info.st_mode))
+            {
+                printf("Control socket path %s exists and is not a socket, not touching it\n", path);
+                status = LED_IO_ERROR;
+                break;
+            }
+            unlink(path);
+        }
+        else if (errno != ENOENT)
+        {
+            printf("Could not check control socket path %s: %s\n", path, strerror(errno));
+            status = LED_IO_ERROR;
+            break;
+        }
+
+        if (bind(server.listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+            listen(server.listenFd, CTRL_LISTEN_BACKLOG) != 0)
+        {
+            printf("Could not listen on control socket %s: %s\n", path, strerror(errno));
+            status = LED_IO_ERROR;
+            break;
+        }
+
+        event.data.ptr = &server.listenFd;
+        epoll_ctl(server.epollFd, EPOLL_CTL_ADD, server.listenFd, &event);
+        event.data.ptr = &server.wakeFd;
+        epoll_ctl(server.epollFd, EPOLL_CTL_ADD, server.wakeFd, &event);
+
+        server.isRunning = true;
+        if (pthread_create(&server.thread, NULL, control_thread, NULL) != 0)
+        {
+            server.isRunning = false;
+            status = LED_BUSY;
+            break;
+        }
+    } while (0);
+
+    // Release whatever was opened before the failure
+    if (status != LED_OK)
+    {
+        int *fds[] = {&server.listenFd, &server.epollFd, &server.wakeFd};
+        for (uint32_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++)
+        {
+            if (*fds[i] >= 0)
+            {
+                close(*fds[i]);
+                *fds[i] = -1;
+            }
+        }
+    }
+    return status;
+}
+
+led_matrix_err_t controlServerStop(void)
+{
+    uint64_t wake = 1;
+
+    if(!server.isRunning) {
+        return LED_ARG_ERROR;
+    }
+    server.isRunning = false;
+    if(write(server.wakeFd, &wake, sizeof(wake)) != sizeof(wake)) {
+        printf("Could not wake control server thread\n");
+    }
+    pthread_join(server.thread, NULL);
+
+    for(uint32_t i = 0; i < CTRL_MAX_CLIENTS; i++) {
+        if(server.clients[i].fd >= 0) {
+            closeClient(&server.clients[i]);
+        }
+    }
+    close(server.listenFd);
+    close(server.epollFd);
+    close(server.wakeFd);
+    server.listenFd = server.epollFd = server.wakeFd = -1;
+    unlink(server.path);
+    return LED_OK;
+}
+
+void controlServerGetStats(ctrl_stats_t *stats)
+{
+    if(stats != NULL) {
+        memcpy(stats, &server.stats, sizeof(ctrl_stats_t));
+    }
+}
+#else
+led_matrix_err_t controlServerStart(const char *path, const ctrl_handlers_t *handlers)
+{
+    (void)path;
+    (void)handlers;
+    printf("Control socket is only supported on Linux\n");
+    return LED_IO_ERROR;
+}
+
+led_matrix_err_t controlServerStop(void)
+{
+    return LED_ARG_ERROR;
+}
+
+void controlServerGetStats(ctrl_stats_t *stats)
+{
+    if(stats != NULL) {
+        memset(stats, 0, sizeof(ctrl_stats_t));
+    }
+}
+#endif /* __linux__ */
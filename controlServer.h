@@ -0,0 +1,126 @@
+/** ********************************************************************************
+*@file controlServer.h
+*@date February 19th, 2026
+*@author julio.liriano (julio.liriano@gmail.com)
+*@brief Local control socket. Lets other processes set/clear the alarm, switch display 
+*       modes, query the clock state and push whole frames over a Unix-domain socket.
+*
+*       Protocol: a stream of messages, each a 4 byte header followed by the payload. 
+*       All fields are in host byte order (the socket is local only). Payload lengths 
+*       are multiples of 4 so every message, and every pushed frame, stays 4 byte aligned.
+*
+*       | opcode (1) | reserved (1) | payload length (2) | payload ...
+*
+*       Commands are not acknowledged. Only CTRL_CMD_QUERY_STATE gets a reply, and a 
+*       command that fails gets a CTRL_RSP_ERROR reply.
+*
+********************************************************************************** */
+#ifndef __CONTROLSERVER_H
+#define __CONTROLSERVER_H
+/* Includes ------------------------------------------------------------------*/
+#include "ledMatrix.h"
+#include <stdint.h>
+#include <stdbool.h>
+/* Exported constants --------------------------------------------------------*/
+#define CTRL_MAX_CLIENTS 64
+#define CTRL_HEADER_SIZE 4
+#define CTRL_MAX_PAYLOAD 64
+/* Exported macros -----------------------------------------------------------*/
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    CTRL_CMD_SET_ALARM = 0x01,      // Payload: ctrl_alarm_t
+    CTRL_CMD_CLEAR_ALARM = 0x02,    // No payload
+    CTRL_CMD_SET_MODE = 0x03,       // Payload: ctrl_mode_t
+    CTRL_CMD_QUERY_STATE = 0x04,    // No payload, replied to with CTRL_RSP_STATE
+    CTRL_CMD_PUSH_FRAME = 0x05,     // Payload: MATRIX_HEIGHT packed rows (matrix_row_t)
+    CTRL_RSP_STATE = 0x80,          // Payload: ctrl_state_t
+    CTRL_RSP_ERROR = 0x81           // Payload: ctrl_error_t
+} ctrl_opcode_t;
+
+typedef struct {
+    uint8_t opcode;
+    uint8_t reserved;
+    uint16_t length;        // Payload length in bytes
+} ctrl_header_t;
+
+typedef struct {
+    uint8_t hour;           // 0-23
+    uint8_t minute;         // 0-59
+    uint8_t reserved[2];
+} ctrl_alarm_t;
+
+typedef struct {
+    uint8_t mode;           // Display mode, as understood by the handler
+    uint8_t reserved[3];
+} ctrl_mode_t;
+
+typedef struct {
+    uint8_t mode;           // Current display mode
+    uint8_t isAlarmSet;
+    uint8_t alarmHour;
+    uint8_t alarmMinute;
+    uint8_t hour;           // Displayed time
+    uint8_t minute;
+    uint8_t reserved[2];
+} ctrl_state_t;
+
+typedef struct {
+    uint8_t opcode;         // Command that failed
+    int8_t status;          // led_matrix_err_t
+    uint8_t reserved[2];
+} ctrl_error_t;
+
+// Called from the server thread. They must be quick and safe to call while the render loop runs.
+typedef struct {
+    led_matrix_err_t (*setAlarm)(bool isSet, uint8_t hour, uint8_t minute);
+    led_matrix_err_t (*setMode)(uint8_t mode);
+    void (*getState)(ctrl_state_t *state);
+    /**
+     * @brief Takes a pushed frame. rows points straight into the receive buffer and is only 
+     *        valid during the call. When a client sends several frames in one batch only the 
+     *        newest is passed on.
+     */
+    led_matrix_err_t (*pushFrame)(const matrix_row_t rows[MATRIX_HEIGHT]);
+} ctrl_handlers_t;
+
+typedef struct {
+    uint64_t wakeups;           // epoll wakeups
+    uint64_t commands;          // Commands handled
+    uint64_t framesPushed;      // Frames received
+    uint64_t framesCoalesced;   // Frames dropped because a newer one arrived in the same batch
+    uint64_t errors;            // Commands rejected (bad length, unknown opcode, handler error)
+    uint32_t clients;           // Clients connected right now
+} ctrl_stats_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Starts listening on a Unix-domain socket and handling commands on a server thread. 
+ *        A socket left at the path by an earlier run is replaced, anything else there is not touched.
+ * 
+ * @param path - Socket path
+ * @param handlers - Command handlers
+ * @return led_matrix_err_t - Status of the operation. LED_IO_ERROR if the path exists and is not a 
+ *                            socket, and on platforms other than Linux.
+ */
+led_matrix_err_t controlServerStart(const char *path, const ctrl_handlers_t *handlers);
+
+/**
+ * @brief Stops the server thread, disconnects all clients and removes the socket file.
+ * 
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t controlServerStop(void);
+
+/**
+ * @brief Gets the server statistics.
+ * 
+ * @param stats - Output statistics.
+ */
+void controlServerGetStats(ctrl_stats_t *stats);
+#endif /* __CONTROLSERVER_H */
+
+
+
@@ -0,0 +1,327 @@
+/** ********************************************************************************
+*@file frameExport.c
+*
+*@date February 9th, 2026
+*
+*@author julio.liriano (julio.liriano@gmail.com)
+*
+*@brief
+********************************************************************************
+
+/* Includes ------------------------------------------------------------------*/
+#include "frameExport.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+
+// Writing is OS dependent. Unix-like systems write the whole ring with a single writev().
+#if defined(_WIN64) || defined(_WIN32)
+    #include <io.h>
+#else
+    #include <unistd.h>
+    #include <sys/uio.h>
+#endif
+
+/* Imported variables --------------------------------------------------------*/
+
+/* Imported function prototypes ----------------------------------------------*/
+
+/* Private constants ---------------------------------------------------------*/
+#define Y4M_FRAME_HEADER "FRAME\n"
+#define PPM_HEADER_MAX_LEN 32
+
+// Output levels. Y4M is written as grayscale (neutral chroma), PPM uses the green 
+// on gray scheme of the classic theme.
+#define Y4M_LUMA_ON 235
+#define Y4M_LUMA_OFF 40
+#define Y4M_CHROMA_NEUTRAL 128
+
+static const uint8_t ppmColorOn[3] = {0, 200, 0};
+static const uint8_t ppmColorOff[3] = {40, 40, 40};
+/* Private macros ------------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    int fd;                     // Output file descriptor
+    bool isOpen; 
+    export_format_t format;
+    uint8_t scale;
+    uint32_t width;             // Output frame width in pixels
+    uint32_t height;            // Output frame height in pixels
+    size_t headerLen;           // Per frame header length (FRAME marker or PPM header)
+    size_t bytesPerPixel;       // Bytes per pixel in the first (or only) plane
+    size_t slotSize;            // Size of one encoded frame in the ring
+    uint8_t *ring;              // EXPORT_RING_SLOTS * slotSize bytes, allocated at open
+    uint32_t slotsUsed;         // Number of encoded frames waiting to be written
+    uint64_t frameCount;
+} frame_export_t;
+
+/* Private variables ---------------------------------------------------------*/
+static frame_export_t exporter = {.fd = -1};
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Writes a buffer to the output, retrying on partial writes.
+ * 
+ * @param buf - Data to write
+ * @param len - Number of bytes
+ * @return led_matrix_err_t - Status of the operation.
+ */
+static led_matrix_err_t writeAll(const uint8_t *buf, size_t len);
+
+/**
+ * @brief Writes all buffered frames in the ring to the output and empties the ring.
+ * 
+ * @return led_matrix_err_t - Status of the operation.
+ */
+static led_matrix_err_t flushRing(void);
+
+/**
+ * @brief Encodes the given frame, scaled up, into a ring slot. Only the pixel data is written, 
+ *        headers (and constant chroma planes for Y4M) were filled in when the ring was allocated.
+ * 
+ * @param slot - Pointer to the start of the ring slot
+ * @param frame - LED matrix frame to encode
+ */
+static void encodeFrame(uint8_t *slot, uint8_t frame[MATRIX_HEIGHT][MATRIX_WIDTH]);
+
+/* Definitions ---------------------------------------------------------------*/
+static led_matrix_err_t writeAll(const uint8_t *buf, size_t len)
+{
+    while(len > 0) {
+#if defined(_WIN64) || defined(_WIN32)
+        int written = _write(exporter.fd, buf, (unsigned int)len);
+#else
+        ssize_t written = write(exporter.fd, buf, len);
+#endif
+        if(written <= 0) {
+            return LED_IO_ERROR;
+        }
+        buf += written;
+        len -= (size_t)written;
+    }
+    return LED_OK;
+}
+
+static led_matrix_err_t flushRing(void)
+{
+    led_matrix_err_t status = LED_OK;
+
+    if(exporter.slotsUsed == 0) {
+        return LED_OK;
+    }
+
+#if defined(_WIN64) || defined(_WIN32)
+    // Slots are contiguous so the whole ring goes out in one write
+    status = writeAll(exporter.ring, exporter.slotsUsed * exporter.slotSize);
+#else
+    struct iovec iov[EXPORT_RING_SLOTS];
+    int iovCnt = (int)exporter.slotsUsed;
+    int first = 0;
+
+    for(int i = 0; i < iovCnt; i++) {
+        iov[i].iov_base = exporter.ring + (size_t)i * exporter.slotSize;
+        iov[i].iov_len = exporter.slotSize;
+    }
+
+    // Pipes may accept less than the whole ring, so keep going from where the last write stopped.
+    while(first < iovCnt) {
+        ssize_t written = writev(exporter.fd, &iov[first], iovCnt - first);
+        if(written <= 0) {
+            status = LED_IO_ERROR;
+            break;
+        }
+        while(first < iovCnt && (size_t)written >= iov[first].iov_len) {
+            written -= (ssize_t)iov[first].iov_len;
+            first++;
+        }
+        if(first < iovCnt) {
+            iov[first].iov_base = (uint8_t *)iov[first].iov_base + written;
+            iov[first].iov_len -= (size_t)written;
+        }
+    }
+#endif
+    exporter.slotsUsed = 0;
+    return status;
+}
+
+static void encodeFrame(uint8_t *slot, uint8_t frame[MATRIX_HEIGHT][MATRIX_WIDTH])
+{
+    uint8_t *out = slot + exporter.headerLen;
+    size_t lineLen = exporter.width * exporter.bytesPerPixel;
+    
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        uint8_t *line = out;
+
+        // Build the first scaled line of this LED row
+        for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+            bool isOn = frame[i][j] != 0;
+            for(uint8_t k = 0; k < exporter.scale; k++) {
+                if(exporter.format == EXPORT_FORMAT_Y4M) {
+                    *out++ = isOn ? Y4M_LUMA_ON : Y4M_LUMA_OFF;
+                } else {
+                    memcpy(out, isOn ? ppmColorOn : ppmColorOff, 3);
+                    out += 3;
+                }
+            }
+        }
+
+        // Remaining lines of the row are copies of the first
+        for(uint8_t k = 1; k < exporter.scale; k++) {
+            memcpy(out, line, lineLen);
+            out += lineLen;
+        }
+    }
+}
+
+led_matrix_err_t frameExportOpen(const char *path, export_format_t format, uint8_t scale, uint32_t fps)
+{
+    led_matrix_err_t status = LED_OK;
+    char header[PPM_HEADER_MAX_LEN + 64] = {0};
+    size_t planeSize = 0;
+    int headerLen = 0;
+
+    do
+    {
+        //Check for valid arguments
+        if (path == NULL || format < 0 || format >= NUM_EXPORT_FORMATS ||
+            scale < 1 || scale > EXPORT_MAX_SCALE || fps == 0)
+        {
+            fprintf(stderr, "Invalid argument: format=%d, scale=%d, fps=%u\n", format, scale, fps);
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        if (exporter.isOpen)
+        {
+            fprintf(stderr, "Frame export is already open\n");
+            status = LED_BUSY;
+            break;
+        }
+
+        exporter.format = format;
+        exporter.scale = scale;
+        exporter.width = MATRIX_WIDTH * scale;
+        exporter.height = MATRIX_HEIGHT * scale;
+        exporter.slotsUsed = 0;
+        exporter.frameCount = 0;
+        planeSize = (size_t)exporter.width * exporter.height;
+
+        if (format == EXPORT_FORMAT_Y4M)
+        {
+            exporter.headerLen = strlen(Y4M_FRAME_HEADER);
+            exporter.bytesPerPixel = 1;
+            exporter.slotSize = exporter.headerLen + 3 * planeSize; // Y, U and V planes
+        }
+        else
+        {
+            headerLen = snprintf(header, sizeof(header), "P6\n%u %u\n255\n", exporter.width, exporter.height);
+            exporter.headerLen = (size_t)headerLen;
+            exporter.bytesPerPixel = 3;
+            exporter.slotSize = exporter.headerLen + 3 * planeSize;
+        }
+
+        exporter.ring = malloc(EXPORT_RING_SLOTS * exporter.slotSize);
+        if (exporter.ring == NULL)
+        {
+            fprintf(stderr, "Could not allocate frame export ring\n");
+            status = LED_IO_ERROR;
+            break;
+        }
+
+        // Fill in everything that does not change between frames
+        for (uint32_t i = 0; i < EXPORT_RING_SLOTS; i++)
+        {
+            uint8_t *slot = exporter.ring + (size_t)i * exporter.slotSize;
+            if (format == EXPORT_FORMAT_Y4M)
+            {
+                memcpy(slot, Y4M_FRAME_HEADER, exporter.headerLen);
+                memset(slot + exporter.headerLen + planeSize, Y4M_CHROMA_NEUTRAL, 2 * planeSize);
+            }
+            else
+            {
+                memcpy(slot, header, exporter.headerLen);
+            }
+        }
+
+        if (strcmp(path, "-") == 0)
+        {
+            exporter.fd = 1; // stdout
+        }
+        else
+        {
+#if defined(_WIN64) || defined(_WIN32)
+            exporter.fd = _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+            exporter.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+        }
+        if (exporter.fd < 0)
+        {
+            fprintf(stderr, "Could not open export file: %s\n", path);
+            free(exporter.ring);
+            exporter.ring = NULL;
+            status = LED_IO_ERROR;
+            break;
+        }
+        exporter.isOpen = true;
+
+        // Y4M has a single stream header, PPM has one per frame
+        if (format == EXPORT_FORMAT_Y4M)
+        {
+            headerLen = snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444\n", 
+                                 exporter.width, exporter.height, fps);
+            status = writeAll((const uint8_t *)header, (size_t)headerLen);
+        }
+    } while (0);
+    return status;
+}
+
+led_matrix_err_t frameExportWrite(void)
+{
+    uint8_t frame[MATRIX_HEIGHT][MATRIX_WIDTH] = {0};
+
+    if(!exporter.isOpen) {
+        return LED_ARG_ERROR;
+    }
+
+    getMatrix(frame);
+    encodeFrame(exporter.ring + (size_t)exporter.slotsUsed * exporter.slotSize, frame);
+    exporter.slotsUsed++;
+    exporter.frameCount++;
+
+    if(exporter.slotsUsed == EXPORT_RING_SLOTS) {
+        return flushRing();
+    }
+    return LED_OK;
+}
+
+led_matrix_err_t frameExportClose(void)
+{
+    led_matrix_err_t status = LED_OK;
+
+    if(!exporter.isOpen) {
+        return LED_ARG_ERROR;
+    }
+
+    status = flushRing();
+    if(exporter.fd != 1) {
+#if defined(_WIN64) || defined(_WIN32)
+        _close(exporter.fd);
+#else
+        close(exporter.fd);
+#endif
+    }
+    free(exporter.ring);
+    exporter.ring = NULL;
+    exporter.fd = -1;
+    exporter.isOpen = false;
+    return status;
+}
+
+uint64_t frameExportCount(void)
+{
+    return exporter.frameCount;
+}
@@ -0,0 +1,65 @@
+/** ********************************************************************************
+*@file frameExport.h
+*@date February 9th, 2026
+*@author julio.liriano (julio.liriano@gmail.com)
+*@brief Streams rendered LED matrix frames to a file or pipe as raw video
+*       (YUV4MPEG2 or a concatenated binary PPM stream). 
+*
+********************************************************************************** */
+#ifndef __FRAMEEXPORT_H
+#define __FRAMEEXPORT_H
+/* Includes ------------------------------------------------------------------*/
+#include "ledMatrix.h"
+#include <stdint.h>
+/* Exported constants --------------------------------------------------------*/
+#define EXPORT_MAX_SCALE 32         // Max number of output pixels per LED (in each direction)
+#define EXPORT_RING_SLOTS 64        // Number of encoded frames buffered before they are written out
+/* Exported macros -----------------------------------------------------------*/
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    EXPORT_FORMAT_Y4M = 0,  // YUV4MPEG2, 4:4:4. Playable with ffplay/mpv, or piped into ffmpeg. 
+    EXPORT_FORMAT_PPM,      // Back to back binary PPM (P6) images, e.g. for "ffmpeg -f image2pipe".
+    NUM_EXPORT_FORMATS // should always be last
+} export_format_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Opens the export stream and allocates the frame ring. All memory is allocated here, 
+ *        writing frames does not allocate.
+ * 
+ * @param path - Output file path. "-" writes to stdout (e.g. to pipe into ffmpeg).
+ * @param format - Output container format.
+ * @param scale - Number of output pixels per LED in each direction (1 to EXPORT_MAX_SCALE).
+ * @param fps - Frame rate written in the stream header (Y4M only).
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t frameExportOpen(const char *path, export_format_t format, uint8_t scale, uint32_t fps);
+
+/**
+ * @brief Encodes the current LED matrix frame into the next ring slot. The ring is written out 
+ *        in a single call once all slots are filled.
+ * 
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t frameExportWrite(void);
+
+/**
+ * @brief Writes out any buffered frames, closes the stream and frees the ring.
+ * 
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t frameExportClose(void);
+
+/**
+ * @brief Returns the number of frames exported since the stream was opened.
+ * 
+ * @return uint64_t - Number of frames.
+ */
+uint64_t frameExportCount(void);
+#endif /* __FRAMEEXPORT_H */
+
+
+
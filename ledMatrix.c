@@ -10,6 +10,8 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "ledMatrix.h"
+#include "matrixTransform.h"
+#include "palette.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
@@ -46,6 +48,39 @@ typedef struct {
  */
 static void setCharAtPosition(character_t character, char_pos_t position);
 
+/**
+ * @brief Returns the sprite for a character, or NULL if the character has no sprite (alarm dot).
+ * 
+ * @param character - character to look up
+ */
+static const uint8_t (*getSprite(character_t character))[SPRITE_WIDTH];
+
+/**
+ * @brief Checks that the character may be set at the given position. Prints the reason if not.
+ * 
+ * @param character 
+ * @param position 
+ * @return led_matrix_err_t - LED_OK if valid, LED_ARG_ERROR otherwise.
+ */
+static led_matrix_err_t checkCharacterAtPosition(character_t character, char_pos_t position);
+
+/**
+ * @brief Writes a packed cell (bit j of each row is sprite column j) into a packed frame.
+ * 
+ * @param target - Top left corner of the cell
+ * @param cell - SPRITE_HEIGHT packed rows
+ * @param rows - Packed frame, the cell is overwritten
+ * @param coverage - Optional (may be NULL), the bits of the cell are set
+ */
+static void writeCell(coordinate_t target, const uint8_t cell[SPRITE_HEIGHT], matrix_row_t rows[MATRIX_HEIGHT], matrix_row_t coverage[MATRIX_HEIGHT]);
+
+/**
+ * @brief Returns the top left corner of a position, including the layout offset.
+ * 
+ * @param position 
+ */
+static coordinate_t getOrigin(char_pos_t position);
+
 /**
  * @brief Used in display of matrix in terminal. Clears the last n lines printed to the terminal.
  * 
@@ -57,6 +92,27 @@ static void clearLastLines(int n);
 // driving the LED matrix.
 uint8_t ledMatrix[MATRIX_HEIGHT][MATRIX_WIDTH] = {0};
 
+// Palette index of each LED as bit planes of packed rows. Only meaningful for lit LEDs.
+static matrix_row_t colorPlanes[COLOR_BITS][MATRIX_HEIGHT] = {0};
+
+// Shift of the digit and colon positions, to spread LED wear
+static int8_t layoutColOffset = 0;
+static int8_t layoutRowOffset = 0;
+
+// LED_BRIGHTNESS_MAX minus the drive level of each LED, 0 is full brightness, 
+// and the same as bit planes of packed rows (the panel's dot correction)
+static uint8_t ledDimming[MATRIX_HEIGHT][MATRIX_WIDTH] = {0};
+static matrix_row_t dimmingPlanes[DIMMING_BITS][MATRIX_HEIGHT] = {0};
+static bool isDimmed = false;
+
+// Frame after the output transform (rotation, mirroring, scaling), as it goes to the panel
+static output_frame_t outputFrame = {0};
+static output_frame_t outputColors[COLOR_BITS] = {0};
+static output_frame_t outputDimming[DIMMING_BITS] = {0};
+
+// Frame in the panel color format
+static uint8_t panelBuffer[PANEL_BUFFER_SIZE];
+
 static const coordinate_t charPositions[NUM_POSITIONS] = {
     [POS1] = {.row = 1, .col = 1},   // POS1
     [POS2] = {.row = 1, .col = 5},   // POS2
@@ -82,6 +138,14 @@ static const uint8_t dashSprite[SPRITE_HEIGHT][SPRITE_WIDTH] = {
     {0, 0, 0}
 };
 
+static const uint8_t dotSprite[SPRITE_HEIGHT][SPRITE_WIDTH] = {
+    {0, 0, 0},
+    {0, 0, 0},
+    {0, 0, 0},
+    {0, 0, 0},
+    {0, 1, 0}
+};
+
 static const uint8_t numberSprites[10][SPRITE_HEIGHT][SPRITE_WIDTH] = {
     // 0
     {
@@ -165,14 +229,219 @@ static const uint8_t numberSprites[10][SPRITE_HEIGHT][SPRITE_WIDTH] = {
     }
 };
 
-static void setCharAtPosition(character_t character, char_pos_t position)
-{
-    coordinate_t target = {0}; 
-    uint8_t const (*spritePtr)[SPRITE_HEIGHT][SPRITE_WIDTH] = NULL; 
-    
-    // Copy over coordinates for the position
-    memcpy(&target, &charPositions[position], sizeof(coordinate_t));
+static const uint8_t letterSprites[26][SPRITE_HEIGHT][SPRITE_WIDTH] = {
+    // A
+    {
+        {0, 1, 0},
+        {1, 0, 1},
+        {1, 1, 1},
+        {1, 0, 1},
+        {1, 0, 1}
+    },
+    // B
+    {
+        {1, 1, 0},
+        {1, 0, 1},
+        {1, 1, 0},
+        {1, 0, 1},
+        {1, 1, 0}
+    },
+    // C
+    {
+        {1, 1, 1},
+        {1, 0, 0},
+        {1, 0, 0},
+        {1, 0, 0},
+        {1, 1, 1}
+    },
+    // D
+    {
+        {1, 1, 0},
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 1, 0}
+    },
+    // E
+    {
+        {1, 1, 1},
+        {1, 0, 0},
+        {1, 1, 0},
+        {1, 0, 0},
+        {1, 1, 1}
+    },
+    // F
+    {
+        {1, 1, 1},
+        {1, 0, 0},
+        {1, 1, 0},
+        {1, 0, 0},
+        {1, 0, 0}
+    },
+    // G
+    {
+        {1, 1, 1},
+        {1, 0, 0},
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 1, 1}
+    },
+    // H
+    {
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 1, 1},
+        {1, 0, 1},
+        {1, 0, 1}
+    },
+    // I
+    {
+        {1, 1, 1},
+        {0, 1, 0},
+        {0, 1, 0},
+        {0, 1, 0},
+        {1, 1, 1}
+    },
+    // J
+    {
+        {0, 0, 1},
+        {0, 0, 1},
+        {0, 0, 1},
+        {1, 0, 1},
+        {1, 1, 1}
+    },
+    // K
+    {
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 1, 0},
+        {1, 0, 1},
+        {1, 0, 1}
+    },
+    // L
+    {
+        {1, 0, 0},
+        {1, 0, 0},
+        {1, 0, 0},
+        {1, 0, 0},
+        {1, 1, 1}
+    },
+    // M
+    {
+        {1, 0, 1},
+        {1, 1, 1},
+        {1, 1, 1},
+        {1, 0, 1},
+        {1, 0, 1}
+    },
+    // N
+    {
+        {1, 1, 0},
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 0, 1}
+    },
+    // O
+    {
+        {0, 1, 0},
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 0, 1},
+        {0, 1, 0}
+    },
+    // P
+    {
+        {1, 1, 1},
+        {1, 0, 1},
+        {1, 1, 1},
+        {1, 0, 0},
+        {1, 0, 0}
+    },
+    // Q
+    {
+        {1, 1, 1},
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 1, 1},
+        {0, 0, 1}
+    },
+    // R
+    {
+        {1, 1, 0},
+        {1, 0, 1},
+        {1, 1, 0},
+        {1, 0, 1},
+        {1, 0, 1}
+    },
+    // S
+    {
+        {0, 1, 1},
+        {1, 0, 0},
+        {0, 1, 0},
+        {0, 0, 1},
+        {1, 1, 0}
+    },
+    // T
+    {
+        {1, 1, 1},
+        {0, 1, 0},
+        {0, 1, 0},
+        {0, 1, 0},
+        {0, 1, 0}
+    },
+    // U
+    {
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 1, 1}
+    },
+    // V
+    {
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 0, 1},
+        {0, 1, 0}
+    },
+    // W
+    {
+        {1, 0, 1},
+        {1, 0, 1},
+        {1, 1, 1},
+        {1, 1, 1},
+        {1, 0, 1}
+    },
+    // X
+    {
+        {1, 0, 1},
+        {1, 0, 1},
+        {0, 1, 0},
+        {1, 0, 1},
+        {1, 0, 1}
+    },
+    // Y
+    {
+        {1, 0, 1},
+        {1, 0, 1},
+        {0, 1, 0},
+        {0, 1, 0},
+        {0, 1, 0}
+    },
+    // Z
+    {
+        {1, 1, 1},
+        {0, 0, 1},
+        {0, 1, 0},
+        {1, 0, 0},
+        {1, 1, 1}
+    }
+};
 
+static const uint8_t (*getSprite(character_t character))[SPRITE_WIDTH]
+{
     // which sprite to use
     switch(character) {
         case ZERO_CHAR:
@@ -186,37 +455,110 @@ static void setCharAtPosition(character_t character, char_pos_t position)
         case EIGHT_CHAR:
         case NINE_CHAR:
             // Intentional fallthrough
-            spritePtr = &numberSprites[character];
-            break;
+            return numberSprites[character];
         case COLON_CHAR:
-            spritePtr = &colonSprite;
-            break;
+            return colonSprite;
         case DASH_CHAR:
-            spritePtr = &dashSprite;
-            break;
+            return dashSprite;
+        case DOT_CHAR:
+            return dotSprite;
+        case ALARM_CHAR_SET:
+        case ALARM_CHAR_CLR:
+            // Alarm dot is a single LED, no sprite
+            return NULL;
+        default:
+            if(character >= A_CHAR && character <= Z_CHAR) {
+                return letterSprites[character - A_CHAR];
+            }
+            return NULL;
+    }
+}
+
+static coordinate_t getOrigin(char_pos_t position)
+{
+    coordinate_t origin = charPositions[position];
+
+    // The alarm dot stays in its corner
+    if(position != ALARM_DOT) {
+        origin.row = (uint8_t)(origin.row + layoutRowOffset);
+        origin.col = (uint8_t)(origin.col + layoutColOffset);
+    }
+    return origin;
+}
+
+static void setCharAtPosition(character_t character, char_pos_t position)
+{
+    coordinate_t target = {0}; 
+    const uint8_t (*sprite)[SPRITE_WIDTH] = NULL; 
+    
+    // Copy over coordinates for the position
+    target = getOrigin(position);
+
+    switch(character) {
         case ALARM_CHAR_SET:
             ledMatrix[target.row][target.col] = 1; // Set the alarm dot (top-right corner)
             return; // No need to copy a sprite for the alarm dot, so we can return early
-            break; 
         case ALARM_CHAR_CLR:
             ledMatrix[target.row][target.col] = 0; // Clear the alarm dot (top-right corner)
             return; // No need to copy a sprite for the alarm dot, so we can return early
-            break;
         default:
-            // Invalid character, should not happen due to prior checks
-            // but will handle here. 
-            return;
+            sprite = getSprite(character);
+            break;
+    }
+
+    if(sprite == NULL) {
+        // Invalid character, should not happen due to prior checks
+        // but will handle here. 
+        return;
     }
 
     // Copy over the sprite for the character to the target position on the matrix
     for(uint8_t i = 0; i < SPRITE_HEIGHT; i++) {
         for(uint8_t j = 0; j < SPRITE_WIDTH; j++) {
-            ledMatrix[target.row + i][target.col + j] = (*spritePtr)[i][j];
+            ledMatrix[target.row + i][target.col + j] = sprite[i][j];
         }   
     }
     return; 
 }
 
+static led_matrix_err_t checkCharacterAtPosition(character_t character, char_pos_t position)
+{
+    //Check for valid arguments
+    if (character < 0 || character >= NUM_CHARACTERS ||
+        position < 0 || position >= NUM_POSITIONS)
+    {
+        printf("Invalid argument: character=%d, position=%d\n", character, position);
+        return LED_ARG_ERROR;
+    }
+
+    // Only colon or decimal point can be set at COLON position
+    if (position == COLON && character != COLON_CHAR && character != DOT_CHAR)
+    {
+        printf("Invalid argument: Only colon or dot can be set at COLON position. character=%d, position=%d\n", character, position);
+        return LED_ARG_ERROR;
+    }
+
+    // Only alarm dot can be set at ALARM_DOT position
+    if (position == ALARM_DOT && (character != ALARM_CHAR_CLR && character != ALARM_CHAR_SET) )
+    {
+        printf("Invalid argument: Only alarm dot can be set at ALARM_DOT position. character=%d, position=%d\n", character, position);
+        return LED_ARG_ERROR;
+    }
+    return LED_OK;
+}
+
+static void writeCell(coordinate_t target, const uint8_t cell[SPRITE_HEIGHT], matrix_row_t rows[MATRIX_HEIGHT], matrix_row_t coverage[MATRIX_HEIGHT])
+{
+    const matrix_row_t mask = ((matrix_row_t)((1U << SPRITE_WIDTH) - 1)) << target.col;
+
+    for(uint8_t i = 0; i < SPRITE_HEIGHT; i++) {
+        rows[target.row + i] = (rows[target.row + i] & ~mask) | ((matrix_row_t)cell[i] << target.col);
+        if(coverage != NULL) {
+            coverage[target.row + i] |= mask;
+        }
+    }
+}
+
 static void clearLastLines(int n) 
 {
     if (n < 1) return;
@@ -236,45 +578,219 @@ static void clearLastLines(int n)
 }
 
 led_matrix_err_t setCharacterAtPosition(character_t character, char_pos_t position)
+{
+    led_matrix_err_t status = checkCharacterAtPosition(character, position);
+
+    if(status == LED_OK) {
+        // Update the matrix with the character sprite at the specified position
+        setCharAtPosition(character, position);
+    }
+    return status;
+}
+
+led_matrix_err_t setCharacterInRows(character_t character, char_pos_t position, matrix_row_t rows[MATRIX_HEIGHT], matrix_row_t coverage[MATRIX_HEIGHT])
 {
     led_matrix_err_t status = LED_OK;
+    uint8_t cell[SPRITE_HEIGHT] = {0};
+    coordinate_t target = {0};
 
     do
     {
-        //Check for valid arguments
-        if (character < 0 || character >= NUM_CHARACTERS ||
-            position < 0 || position >= NUM_POSITIONS)
+        if (rows == NULL)
         {
-            printf("Invalid argument: character=%d, position=%d\n", character, position);
             status = LED_ARG_ERROR;
             break;
         }
 
-        // Only colon can be set at COLON position
-        if (position == COLON && character != COLON_CHAR)
+        status = checkCharacterAtPosition(character, position);
+        if (status != LED_OK)
         {
-            printf("Invalid argument: Only colon can be set at COLON position. character=%d, position=%d\n", character, position);
-            status = LED_ARG_ERROR;
             break;
         }
+        target = getOrigin(position);
 
-        // Only alarm dot can be set at ALARM_DOT position
-        if (position == ALARM_DOT && (character != ALARM_CHAR_CLR && character != ALARM_CHAR_SET) )
+        // Alarm dot is a single LED
+        if (character == ALARM_CHAR_SET || character == ALARM_CHAR_CLR)
         {
-            printf("Invalid argument: Only alarm dot can be set at ALARM_DOT position. character=%d, position=%d\n", character, position);
-            status = LED_ARG_ERROR;
+            matrix_row_t bit = (matrix_row_t)1 << target.col;
+            rows[target.row] = (character == ALARM_CHAR_SET) ? (rows[target.row] | bit) : (rows[target.row] & ~bit);
+            if (coverage != NULL)
+            {
+                coverage[target.row] |= bit;
+            }
             break;
         }
 
-        // Update the matrix with the character sprite at the specified position
-        setCharAtPosition(character, position);
-
+        // Pack each sprite row and write the whole row of the cell at once
+        getCharacterCell(character, cell);
+        writeCell(target, cell, rows, coverage);
     } while (0);
     return status;
 }
 
+led_matrix_err_t getCharacterCell(character_t character, uint8_t cellOut[SPRITE_HEIGHT])
+{
+    const uint8_t (*sprite)[SPRITE_WIDTH] = NULL;
+
+    if (character < 0 || character >= NUM_CHARACTERS || cellOut == NULL)
+    {
+        printf("Invalid argument: character=%d\n", character);
+        return LED_ARG_ERROR;
+    }
+
+    sprite = getSprite(character);
+    if (sprite == NULL)
+    {
+        return LED_ARG_ERROR; // Alarm dot has no sprite
+    }
+    for (uint8_t i = 0; i < SPRITE_HEIGHT; i++)
+    {
+        cellOut[i] = 0;
+        for (uint8_t j = 0; j < SPRITE_WIDTH; j++)
+        {
+            cellOut[i] |= (uint8_t)((sprite[i][j] != 0) << j);
+        }
+    }
+    return LED_OK;
+}
+
+led_matrix_err_t setCellInRows(char_pos_t position, const uint8_t cell[SPRITE_HEIGHT], matrix_row_t rows[MATRIX_HEIGHT], matrix_row_t coverage[MATRIX_HEIGHT])
+{
+    if (position < 0 || position >= ALARM_DOT || cell == NULL || rows == NULL)
+    {
+        printf("Invalid argument: position=%d\n", position);
+        return LED_ARG_ERROR;
+    }
+    writeCell(getOrigin(position), cell, rows, coverage);
+    return LED_OK;
+}
+
+led_matrix_err_t getLayoutCoverage(int8_t colOffset, int8_t rowOffset, matrix_row_t coverageOut[MATRIX_HEIGHT])
+{
+    static const uint8_t fullCell[SPRITE_HEIGHT] = {0x7, 0x7, 0x7, 0x7, 0x7};
+    matrix_row_t rows[MATRIX_HEIGHT] = {0};
+    coordinate_t dot = charPositions[ALARM_DOT];
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(coverageOut == NULL || colOffset < -LAYOUT_MAX_OFFSET || colOffset > LAYOUT_MAX_OFFSET ||
+           rowOffset < -LAYOUT_MAX_OFFSET || rowOffset > LAYOUT_MAX_OFFSET) {
+            printf("Invalid argument: layout offset=(%d, %d)\n", colOffset, rowOffset);
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        memset(coverageOut, 0, sizeof(matrix_row_t) * MATRIX_HEIGHT);
+        for(char_pos_t position = POS1; position < ALARM_DOT; position++) {
+            int16_t row = charPositions[position].row + rowOffset;
+            int16_t col = charPositions[position].col + colOffset;
+            if(row < 0 || col < 0 || row + SPRITE_HEIGHT > MATRIX_HEIGHT || col + SPRITE_WIDTH > MATRIX_WIDTH) {
+                status = LED_ARG_ERROR;
+                break;
+            }
+            writeCell((coordinate_t){.row = (uint8_t)row, .col = (uint8_t)col}, fullCell, rows, coverageOut);
+        }
+        if(status == LED_OK && ((coverageOut[dot.row] >> dot.col) & 1U)) {
+            status = LED_ARG_ERROR;
+        }
+    } while(0);
+    return status;
+}
+
+led_matrix_err_t setLayoutOffset(int8_t colOffset, int8_t rowOffset)
+{
+    matrix_row_t coverage[MATRIX_HEIGHT];
+
+    if(getLayoutCoverage(colOffset, rowOffset, coverage) != LED_OK) {
+        return LED_ARG_ERROR;
+    }
+    layoutColOffset = colOffset;
+    layoutRowOffset = rowOffset;
+    return LED_OK;
+}
+
+void getLayoutOffset(int8_t *colOffsetOut, int8_t *rowOffsetOut)
+{
+    if(colOffsetOut != NULL) {
+        *colOffsetOut = layoutColOffset;
+    }
+    if(rowOffsetOut != NULL) {
+        *rowOffsetOut = layoutRowOffset;
+    }
+}
+
+void setLedBrightness(const uint8_t levels[MATRIX_HEIGHT][MATRIX_WIDTH])
+{
+    isDimmed = false;
+    memset(dimmingPlanes, 0, sizeof(dimmingPlanes));
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+            ledDimming[i][j] = (uint8_t)(LED_BRIGHTNESS_MAX - levels[i][j]);
+            isDimmed |= (ledDimming[i][j] != 0);
+            for(uint8_t b = 0; b < DIMMING_BITS; b++) {
+                dimmingPlanes[b][i] |= (matrix_row_t)((ledDimming[i][j] >> b) & 1U) << j;
+            }
+        }
+    }
+}
+
+led_matrix_err_t getLedBrightness(uint8_t levelsOut[MATRIX_HEIGHT][MATRIX_WIDTH])
+{
+    // Check for NULL pointer
+    if(levelsOut == NULL) {
+        return LED_ARG_ERROR;
+    }
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+            levelsOut[i][j] = (uint8_t)(LED_BRIGHTNESS_MAX - ledDimming[i][j]);
+        }
+    }
+    return LED_OK;
+}
+
+void setMatrixRows(const matrix_row_t rows[MATRIX_HEIGHT])
+{
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+            ledMatrix[i][j] = (rows[i] >> j) & 1U;
+        }
+    }
+}
+
+led_matrix_err_t getMatrixRows(matrix_row_t rowsOut[MATRIX_HEIGHT])
+{
+    // Check for NULL pointer
+    if(rowsOut == NULL) {
+        return LED_ARG_ERROR;
+    }
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        matrix_row_t row = 0;
+        for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+            row |= (matrix_row_t)(ledMatrix[i][j] != 0) << j;
+        }
+        rowsOut[i] = row;
+    }
+    return LED_OK;
+}
+
+void setMatrixColors(const matrix_row_t planes[COLOR_BITS][MATRIX_HEIGHT])
+{
+    memcpy(colorPlanes, planes, sizeof(colorPlanes));
+}
+
+led_matrix_err_t getMatrixColors(matrix_row_t planesOut[COLOR_BITS][MATRIX_HEIGHT])
+{
+    // Check for NULL pointer
+    if(planesOut == NULL) {
+        return LED_ARG_ERROR;
+    }
+    memcpy(planesOut, colorPlanes, sizeof(colorPlanes));
+    return LED_OK;
+}
+
 void clearMatrix(void) {
     memset(ledMatrix, 0, sizeof(ledMatrix));
+    memset(colorPlanes, 0, sizeof(colorPlanes));
 }
 
 led_matrix_err_t getMatrix(uint8_t matrixOut[MATRIX_HEIGHT][MATRIX_WIDTH]) {
@@ -289,29 +805,74 @@ led_matrix_err_t getMatrix(uint8_t matrixOut[MATRIX_HEIGHT][MATRIX_WIDTH]) {
 
 led_matrix_err_t sendMatrix(void) {
     led_matrix_err_t status = LED_OK;
+    matrix_row_t rows[MATRIX_HEIGHT] = {0};
+
+    // Orient and scale the frame, its colors and the LED dimming for the panel, then convert 
+    // to the panel's pixel format with each LED at its drive level
+    getMatrixRows(rows);
+    transformFrame(rows, &outputFrame);
+    for(uint8_t b = 0; b < COLOR_BITS; b++) {
+        transformFrame(colorPlanes[b], &outputColors[b]);
+    }
+    for(uint8_t b = 0; b < DIMMING_BITS && isDimmed; b++) {
+        transformFrame(dimmingPlanes[b], &outputDimming[b]);
+    }
+    paletteConvertFrame(&outputFrame, outputColors, isDimmed ? outputDimming : NULL, panelBuffer);
+
     // This function would interface with the hardware-specific LED matrix driver
-    // to send the current ledMatrix frame to the actual LED matrix hardware.
+    // to send the current ledMatrix frame to the actual LED matrix hardware. 
     // I would update this function to return error codes based on the hardware driver feedback.
     return status; 
 }
 
 void printMatrix(void) {
     static bool firstPrint = true;
+    static uint16_t lastHeight = 0;
+    matrix_row_t rows[MATRIX_HEIGHT] = {0};
     
     // Determine if this is first print
     if (!firstPrint) {
         // clear the last printed matrix from the terminal before printing the new one
-        clearLastLines(MATRIX_HEIGHT);
+        clearLastLines(lastHeight);
     } else {
         firstPrint = false;
     }
 
+    // Show the frame the way the panel would, after the output transform
+    getMatrixRows(rows);
+    transformFrame(rows, &outputFrame);
+    for(uint8_t b = 0; b < COLOR_BITS; b++) {
+        transformFrame(colorPlanes[b], &outputColors[b]);
+    }
+    lastHeight = outputFrame.height;
+
+    // The brightness levels go through the output transform the same way, one bit plane at a time
+    for(uint8_t b = 0; b < DIMMING_BITS && isDimmed; b++) {
+        transformFrame(dimmingPlanes[b], &outputDimming[b]);
+    }
+
     // Print the matrix
-    for (uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
-        for (uint8_t j = 0; j < MATRIX_WIDTH; j++) {
-            // Green filled circle for 1, gray hollow circle for 0. 
+    for (uint16_t i = 0; i < outputFrame.height; i++) {
+        for (uint16_t j = 0; j < outputFrame.width; j++) {
+            // Filled circle in the LED's palette color for 1, gray hollow circle for 0. 
             // I found this pleaseing though UI/UX folks may not :). 
-            printf("%s ", ledMatrix[i][j] != 0 ? "\x1b[32m\u25CF\x1b[0m" : "\033[90m\xe2\x97\xa6\033[0m"); //
+            if (getOutputPixel(&outputFrame, j, i)) {
+                color_index_t index = 0;
+                for (uint8_t b = 0; b < COLOR_BITS; b++) {
+                    index |= (color_index_t)(getOutputPixel(&outputColors[b], j, i) << b);
+                }
+                rgb_color_t color = paletteGetColor(index);
+                uint16_t level = LED_BRIGHTNESS_MAX;
+                for (uint8_t b = 0; b < DIMMING_BITS && isDimmed; b++) {
+                    level -= (uint16_t)(getOutputPixel(&outputDimming[b], j, i) << b);
+                }
+                color.r = (uint8_t)(color.r * level / LED_BRIGHTNESS_MAX);
+                color.g = (uint8_t)(color.g * level / LED_BRIGHTNESS_MAX);
+                color.b = (uint8_t)(color.b * level / LED_BRIGHTNESS_MAX);
+                printf("\x1b[38;2;%u;%u;%um\u25CF\x1b[0m ", color.r, color.g, color.b);
+            } else {
+                printf("\033[90m\xe2\x97\xa6\033[0m ");
+            }
         }
         printf("\r\n");
     }
@@ -16,9 +16,30 @@
 
 #define SPRITE_WIDTH 3
 #define SPRITE_HEIGHT 5
+
+#define MATRIX_ROW_ALL ((matrix_row_t)((1UL << MATRIX_WIDTH) - 1)) // Every column of a packed row set
+
+// Palette index bits per LED (2 to 4), e.g. -DCOLOR_BITS=4 for a 16 color palette
+#ifndef COLOR_BITS
+#define COLOR_BITS 2
+#endif
+#if COLOR_BITS < 2 || COLOR_BITS > 4
+#error "COLOR_BITS must be 2 to 4"
+#endif
+#define PALETTE_SIZE (1 << COLOR_BITS)
+
+#define LAYOUT_MAX_OFFSET 1         // Pixels the clock layout can be shifted by in each direction
+#define LED_BRIGHTNESS_MAX 255      // Full drive level of an LED
 /* Exported macros -----------------------------------------------------------*/
 
 /* Exported types ------------------------------------------------------------*/
+// Packed matrix row, one bit per LED. Bit j is column j. Lets whole rows be handled with word-wide bit operations.
+typedef uint32_t matrix_row_t;
+
+// Palette entry of a lit LED. Colors are stored as COLOR_BITS bit planes of packed rows, 
+// bit j of planes[b][i] is bit b of the index of the LED at row i, column j.
+typedef uint8_t color_index_t;
+
 // These define the enums for the starting positions of each character on the matrix. 
 typedef enum {
     POS1 = 0,
@@ -43,8 +64,35 @@ typedef enum {
     NINE_CHAR,
     COLON_CHAR, 
     DASH_CHAR,
+    DOT_CHAR, // Decimal point, shares the COLON position
     ALARM_CHAR_SET,
     ALARM_CHAR_CLR,
+    A_CHAR, // Letters (e.g. zone labels), in alphabetical order
+    B_CHAR,
+    C_CHAR,
+    D_CHAR,
+    E_CHAR,
+    F_CHAR,
+    G_CHAR,
+    H_CHAR,
+    I_CHAR,
+    J_CHAR,
+    K_CHAR,
+    L_CHAR,
+    M_CHAR,
+    N_CHAR,
+    O_CHAR,
+    P_CHAR,
+    Q_CHAR,
+    R_CHAR,
+    S_CHAR,
+    T_CHAR,
+    U_CHAR,
+    V_CHAR,
+    W_CHAR,
+    X_CHAR,
+    Y_CHAR,
+    Z_CHAR,
     NUM_CHARACTERS // should always be last 
 } character_t;
 
@@ -52,14 +100,15 @@ typedef enum {
     LED_OK = 0, 
     LED_BUSY = -1, 
     LED_OVERHEAT = -2, 
-    LED_ARG_ERROR = -3
+    LED_ARG_ERROR = -3,
+    LED_IO_ERROR = -4
 } led_matrix_err_t;
 
 /* Exported variables --------------------------------------------------------*/
 
 /* Exported functions --------------------------------------------------------*/
 /**
- * @brief Clears LED matrix. Sets all positions to zero. 
+ * @brief Clears LED matrix. Sets all positions and palette indices to zero. 
  * 
  */
 void clearMatrix(void);
@@ -72,6 +121,115 @@ void clearMatrix(void);
  */
 led_matrix_err_t setCharacterAtPosition(character_t character, char_pos_t position);
 
+/**
+ * @brief Draws the character at the specified position into a packed frame instead of the LED matrix. 
+ *        Follows the same rules as setCharacterAtPosition().
+ * 
+ * @param character 
+ * @param position 
+ * @param rows - Packed frame to draw into. The character's cell is overwritten.
+ * @param coverage - Optional (may be NULL). The bits of the character's cell are set.
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t setCharacterInRows(character_t character, char_pos_t position, matrix_row_t rows[MATRIX_HEIGHT], matrix_row_t coverage[MATRIX_HEIGHT]);
+
+/**
+ * @brief Gets the sprite of a character as packed cell rows, bit j of each row is sprite column j.
+ * 
+ * @param character 
+ * @param cellOut - SPRITE_HEIGHT packed rows.
+ * @return led_matrix_err_t - LED_ARG_ERROR for characters without a sprite (alarm dot).
+ */
+led_matrix_err_t getCharacterCell(character_t character, uint8_t cellOut[SPRITE_HEIGHT]);
+
+/**
+ * @brief Draws a packed cell (e.g. a frame of an animation between two characters) at a character 
+ *        position into a packed frame.
+ * 
+ * @param position - POS1 to POS4 or COLON
+ * @param cell - SPRITE_HEIGHT packed rows, as returned by getCharacterCell().
+ * @param rows - Packed frame to draw into. The cell is overwritten.
+ * @param coverage - Optional (may be NULL). The bits of the cell are set.
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t setCellInRows(char_pos_t position, const uint8_t cell[SPRITE_HEIGHT], matrix_row_t rows[MATRIX_HEIGHT], matrix_row_t coverage[MATRIX_HEIGHT]);
+
+/**
+ * @brief Shifts the digit and colon positions (everything but the alarm dot) by up to 
+ *        LAYOUT_MAX_OFFSET pixels, e.g. to spread LED wear. Applies to everything drawn 
+ *        afterwards. The default is no offset.
+ * 
+ * @param colOffset - Columns to the right (negative to the left)
+ * @param rowOffset - Rows down (negative up)
+ * @return led_matrix_err_t - LED_ARG_ERROR if the layout would not fit or would cover the alarm dot.
+ */
+led_matrix_err_t setLayoutOffset(int8_t colOffset, int8_t rowOffset);
+
+/**
+ * @brief Gets the current layout offset.
+ * 
+ * @param colOffsetOut 
+ * @param rowOffsetOut 
+ */
+void getLayoutOffset(int8_t *colOffsetOut, int8_t *rowOffsetOut);
+
+/**
+ * @brief Gets the pixels the digit and colon cells would cover at a layout offset.
+ * 
+ * @param colOffset 
+ * @param rowOffset 
+ * @param coverageOut - Packed coverage rows, MATRIX_HEIGHT rows.
+ * @return led_matrix_err_t - LED_ARG_ERROR if the layout would not fit or would cover the alarm dot.
+ */
+led_matrix_err_t getLayoutCoverage(int8_t colOffset, int8_t rowOffset, matrix_row_t coverageOut[MATRIX_HEIGHT]);
+
+/**
+ * @brief Sets the drive level of each LED (0 to LED_BRIGHTNESS_MAX). Sent frames are converted 
+ *        with each lit LED scaled to its level. The default is full brightness for every LED.
+ * 
+ * @param levels - Level of each LED.
+ */
+void setLedBrightness(const uint8_t levels[MATRIX_HEIGHT][MATRIX_WIDTH]);
+
+/**
+ * @brief Gets the drive level of each LED.
+ * 
+ * @param levelsOut - Output, level of each LED.
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t getLedBrightness(uint8_t levelsOut[MATRIX_HEIGHT][MATRIX_WIDTH]);
+
+/**
+ * @brief Replaces the LED matrix frame with a packed frame.
+ * 
+ * @param rows - Packed frame, MATRIX_HEIGHT rows.
+ */
+void setMatrixRows(const matrix_row_t rows[MATRIX_HEIGHT]);
+
+/**
+ * @brief Replaces the palette indices of the LED matrix frame. setMatrixRows() and the other 
+ *        drawing functions leave the colors as they are.
+ * 
+ * @param planes - COLOR_BITS bit planes of MATRIX_HEIGHT packed rows.
+ */
+void setMatrixColors(const matrix_row_t planes[COLOR_BITS][MATRIX_HEIGHT]);
+
+/**
+ * @brief Get the palette indices of the current LED matrix frame.
+ * 
+ * @param planesOut - Output, COLOR_BITS bit planes of MATRIX_HEIGHT packed rows.
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t getMatrixColors(matrix_row_t planesOut[COLOR_BITS][MATRIX_HEIGHT]);
+
+/**
+ * @brief Get the current LED matrix frame as packed rows.
+ * 
+ * @param rowsOut - Output packed frame, MATRIX_HEIGHT rows.
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t getMatrixRows(matrix_row_t rowsOut[MATRIX_HEIGHT]);
+
 /**
  * @brief Get the current LED matrix frame.
  * 
@@ -81,7 +239,8 @@ led_matrix_err_t setCharacterAtPosition(character_t character, char_pos_t positi
 led_matrix_err_t getMatrix(uint8_t matrixOut[MATRIX_HEIGHT][MATRIX_WIDTH]); 
 
 /**
- * @brief Sends the current ledMatrix frame to the LED matrix hardware.
+ * @brief Sends the current ledMatrix frame to the LED matrix hardware. The frame is transformed 
+ *        for the panel and converted to the panel color format (see palette.h).
  * 
  * @return led_matrix_err_t Status of the operation.
  */
@@ -89,6 +248,7 @@ led_matrix_err_t sendMatrix(void);
 
 /**
  * @brief Prints the current LED matrix to the terminal. This is a utility function for testing and visualization purposes.
+ *        Lit LEDs are shown in their palette color, scaled by their brightness (needs a terminal with 24-bit color).
  * 
  */
 void printMatrix(void);
@@ -0,0 +1,400 @@
+/** ********************************************************************************
+*@file ledWear.c
+*
+*@date March 16th, 2026
+*
+*@author julio.liriano (julio.liriano@gmail.com)
+*
+*@brief
+********************************************************************************
+
+/* Includes ------------------------------------------------------------------*/
+#include "ledWear.h"
+#include "timeFuncs.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Imported variables --------------------------------------------------------*/
+
+/* Imported function prototypes ----------------------------------------------*/
+
+/* Private constants ---------------------------------------------------------*/
+#define WEAR_FILE_MAGIC 0x5745444CU                     // "LDEW"
+#define WEAR_FILE_VERSION 1
+#define WEAR_TICK_NSEC (WEAR_TICK_MS * NSEC_PER_MSEC)
+
+// Counters hold up to a flush period of ticks plus a frame shown for less than one
+#if (1 << WEAR_SLICE_BITS) < 2 * WEAR_FLUSH_TICKS
+#error "WEAR_SLICE_BITS too small for WEAR_FLUSH_TICKS"
+#endif
+/* Private macros ------------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t width;
+    uint8_t height;
+    uint32_t tickMs;
+    uint32_t reserved;
+    uint64_t totalTicks;                                // Running time of the panel
+    uint64_t onTicks[MATRIX_HEIGHT][MATRIX_WIDTH];      // On-time of each LED
+} wear_file_t;
+
+/* Private variables ---------------------------------------------------------*/
+static wear_file_t *wearFile = NULL;                    // Mapped wear file, NULL while closed
+
+// Bit sliced counters: bit j of slices[i][k] is bit k of the count of LED (i, j), so adding to
+// every LED of a row is a handful of word operations.
+static matrix_row_t slices[MATRIX_HEIGHT][WEAR_SLICE_BITS];
+static uint64_t pendingTicks = 0;                       // Ticks in the counters, not yet in the file
+
+static matrix_row_t shownRows[MATRIX_HEIGHT];           // Frame on the panel since lastTick
+static uint64_t lastTick = 0;
+static bool isFrameShown = false;
+
+static wear_stats_t wearStats = {0};
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Adds count to the counters of the lit LEDs, one full adder per counter bit.
+ *
+ */
+static void addToSlices(const matrix_row_t rows[MATRIX_HEIGHT], uint64_t count);
+
+/**
+ * @brief Adds the ticks a frame was shown to its lit LEDs and to the running time.
+ *
+ */
+static void addTicks(const matrix_row_t rows[MATRIX_HEIGHT], uint64_t ticks);
+
+/**
+ * @brief Folds the counters into the file and clears them.
+ *
+ */
+static void flushSlices(void);
+
+/**
+ * @brief Returns the on-time summed over the digit and colon cells at a layout offset, or
+ *        UINT64_MAX if the offset is not a valid layout.
+ *
+ */
+static uint64_t getLayoutWear(int8_t colOffset, int8_t rowOffset);
+
+/* Definitions ---------------------------------------------------------------*/
+static void addToSlices(const matrix_row_t rows[MATRIX_HEIGHT], uint64_t count)
+{
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        matrix_row_t lit = rows[i];
+        matrix_row_t carry = 0;
+
+        if(lit == 0) {
+            continue;
+        }
+        // Bit k of count goes to every lit LED of the row. Stops once both the count and
+        // the carry run out, which for the usual count of 1 is after a bit or two.
+        for(uint8_t k = 0; k < WEAR_SLICE_BITS && ((count >> k) != 0 || carry != 0); k++) {
+            matrix_row_t addend = ((count >> k) & 1U) ? lit : 0;
+            matrix_row_t sum = slices[i][k] ^ addend ^ carry;
+            carry = (slices[i][k] & addend) | (carry & (slices[i][k] ^ addend));
+            slices[i][k] = sum;
+        }
+    }
+}
+
+static void addTicks(const matrix_row_t rows[MATRIX_HEIGHT], uint64_t ticks)
+{
+    // A frame shown for a whole flush period (a stall or a large time scale) would be folded right 
+    // away, add it straight to the file
+    if(ticks >= WEAR_FLUSH_TICKS) {
+        for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+            for(matrix_row_t lit = rows[i]; lit != 0; lit &= lit - 1) {
+                wearFile->onTicks[i][__builtin_ctz(lit)] += ticks;
+            }
+        }
+        wearFile->totalTicks += ticks;
+        wearStats.ticks += ticks;
+        return;
+    }
+
+    addToSlices(rows, ticks);
+    pendingTicks += ticks;
+    wearStats.ticks += ticks;
+    if(pendingTicks >= WEAR_FLUSH_TICKS) {
+        flushSlices();
+    }
+}
+
+static void flushSlices(void)
+{
+    uint64_t startNsec = getMonotonicNsec(TICK_SOURCE_PRECISE);
+
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        for(uint8_t k = 0; k < WEAR_SLICE_BITS; k++) {
+            for(matrix_row_t plane = slices[i][k]; plane != 0; plane &= plane - 1) {
+                wearFile->onTicks[i][__builtin_ctz(plane)] += 1ULL << k;
+            }
+        }
+    }
+    wearFile->totalTicks += pendingTicks;
+    memset(slices, 0, sizeof(slices));
+    pendingTicks = 0;
+
+    // Let the kernel write it back in its own time, a crash loses at most a minute of counts
+    msync(wearFile, sizeof(wear_file_t), MS_ASYNC);
+
+    uint64_t elapsedNsec = getMonotonicNsec(TICK_SOURCE_PRECISE) - startNsec;
+    wearStats.flushes++;
+    wearStats.flushNsec += elapsedNsec;
+    if(elapsedNsec > wearStats.maxFlushNsec) {
+        wearStats.maxFlushNsec = elapsedNsec;
+    }
+}
+
+static uint64_t getLayoutWear(int8_t colOffset, int8_t rowOffset)
+{
+    matrix_row_t coverage[MATRIX_HEIGHT];
+    uint64_t wear = 0;
+
+    if(getLayoutCoverage(colOffset, rowOffset, coverage) != LED_OK) {
+        return UINT64_MAX;
+    }
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        for(matrix_row_t cell = coverage[i]; cell != 0; cell &= cell - 1) {
+            wear += wearFile->onTicks[i][__builtin_ctz(cell)];
+        }
+    }
+    return wear;
+}
+
+led_matrix_err_t wearOpen(const char *path)
+{
+    struct stat info;
+    int fd = -1;
+    void *map = MAP_FAILED;
+    bool isNew = false;
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(path == NULL) {
+            printf("Invalid argument: wear file path is NULL\n");
+            status = LED_ARG_ERROR;
+            break;
+        }
+        if(wearFile != NULL) {
+            printf("Wear file is already open\n");
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        // Only a file that was just created (empty) is sized and initialised, anything else must already be a wear file
+        fd = open(path, O_RDWR | O_CREAT, 0644);
+        if(fd < 0 || fstat(fd, &info) != 0) {
+            printf("Could not open wear file %s: %s\n", path, strerror(errno));
+            if(fd >= 0) {
+                close(fd);
+            }
+            status = LED_IO_ERROR;
+            break;
+        }
+        isNew = (info.st_size == 0);
+        if(!S_ISREG(info.st_mode) || (!isNew && info.st_size != (off_t)sizeof(wear_file_t))) {
+            printf("%s is not a wear file for this panel, not touching it\n", path);
+            close(fd);
+            status = LED_IO_ERROR;
+            break;
+        }
+        if(isNew && ftruncate(fd, sizeof(wear_file_t)) != 0) {
+            printf("Could not size wear file %s: %s\n", path, strerror(errno));
+            close(fd);
+            status = LED_IO_ERROR;
+            break;
+        }
+        map = mmap(NULL, sizeof(wear_file_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd); // The mapping keeps the file
+        if(map == MAP_FAILED) {
+            printf("Could not map wear file %s: %s\n", path, strerror(errno));
+            status = LED_IO_ERROR;
+            break;
+        }
+
+        wearFile = map;
+        if(!isNew && (wearFile->magic != WEAR_FILE_MAGIC || wearFile->version != WEAR_FILE_VERSION || wearFile->width != MATRIX_WIDTH ||
+                      wearFile->height != MATRIX_HEIGHT || wearFile->tickMs != WEAR_TICK_MS)) {
+            printf("%s is not a wear file for this panel, not touching it\n", path);
+            munmap(map, sizeof(wear_file_t));
+            wearFile = NULL;
+            status = LED_IO_ERROR;
+            break;
+        }
+        if(isNew) {
+            // ftruncate() filled it with zeros
+            wearFile->magic = WEAR_FILE_MAGIC;
+            wearFile->version = WEAR_FILE_VERSION;
+            wearFile->width = MATRIX_WIDTH;
+            wearFile->height = MATRIX_HEIGHT;
+            wearFile->tickMs = WEAR_TICK_MS;
+        }
+
+        memset(slices, 0, sizeof(slices));
+        pendingTicks = 0;
+        isFrameShown = false;
+        wearStats = (wear_stats_t){0};
+    } while(0);
+    return status;
+}
+
+led_matrix_err_t wearClose(uint64_t tickNsec)
+{
+    uint64_t tick = tickNsec / WEAR_TICK_NSEC;
+    led_matrix_err_t status = LED_OK;
+
+    if(wearFile == NULL) {
+        return LED_ARG_ERROR;
+    }
+    // The last frame sent was on the panel until now
+    if(isFrameShown && tick > lastTick) {
+        addTicks(shownRows, tick - lastTick);
+    }
+    isFrameShown = false;
+    flushSlices();
+    if(msync(wearFile, sizeof(wear_file_t), MS_SYNC) != 0) {
+        printf("Could not write wear file: %s\n", strerror(errno));
+        status = LED_IO_ERROR;
+    }
+    munmap(wearFile, sizeof(wear_file_t));
+    wearFile = NULL;
+    return status;
+}
+
+void wearRecordFrame(const matrix_row_t rows[MATRIX_HEIGHT], uint64_t tickNsec)
+{
+    uint64_t tick = tickNsec / WEAR_TICK_NSEC;
+
+    if(wearFile == NULL || rows == NULL) {
+        return;
+    }
+
+    // The previous frame was on the panel for every tick boundary crossed since it was sent
+    if(isFrameShown && tick > lastTick) {
+        addTicks(shownRows, tick - lastTick);
+    }
+    memcpy(shownRows, rows, sizeof(shownRows));
+    lastTick = tick;
+    isFrameShown = true;
+    wearStats.frames++;
+}
+
+led_matrix_err_t wearFlush(void)
+{
+    if(wearFile == NULL) {
+        return LED_ARG_ERROR;
+    }
+    flushSlices();
+    return LED_OK;
+}
+
+led_matrix_err_t wearGetOnTime(uint64_t onTicksOut[MATRIX_HEIGHT][MATRIX_WIDTH], uint64_t *totalTicksOut)
+{
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(onTicksOut == NULL) {
+            printf("Invalid argument: onTicksOut is NULL\n");
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        if(wearFile == NULL) {
+            status = LED_ARG_ERROR;
+            break;
+        }
+        flushSlices();
+        memcpy(onTicksOut, wearFile->onTicks, sizeof(wearFile->onTicks));
+        if(totalTicksOut != NULL) {
+            *totalTicksOut = wearFile->totalTicks;
+        }
+    } while(0);
+    return status;
+}
+
+led_matrix_err_t wearApplyLeveling(wear_policy_t policy)
+{
+    static uint8_t levels[MATRIX_HEIGHT][MATRIX_WIDTH];
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(policy < 0 || policy >= NUM_WEAR_POLICIES) {
+            printf("Invalid argument: wear policy=%d\n", policy);
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        if(wearFile == NULL) {
+            status = LED_ARG_ERROR;
+            break;
+        }
+        flushSlices();
+
+        switch(policy) {
+            case WEAR_LEVEL_SHIFT: {
+                int8_t bestCol = 0;
+                int8_t bestRow = 0;
+                uint64_t bestWear = 0;
+
+                getLayoutOffset(&bestCol, &bestRow);
+                bestWear = getLayoutWear(bestCol, bestRow);
+                for(int8_t row = -LAYOUT_MAX_OFFSET; row <= LAYOUT_MAX_OFFSET; row++) {
+                    for(int8_t col = -LAYOUT_MAX_OFFSET; col <= LAYOUT_MAX_OFFSET; col++) {
+                        uint64_t wear = getLayoutWear(col, row);
+                        if(wear < bestWear) {
+                            bestWear = wear;
+                            bestCol = col;
+                            bestRow = row;
+                        }
+                    }
+                }
+                status = setLayoutOffset(bestCol, bestRow);
+                break;
+            }
+            case WEAR_LEVEL_DIM: {
+                uint64_t maxOnTicks = 0;
+
+                for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+                    for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+                        if(wearFile->onTicks[i][j] > maxOnTicks) {
+                            maxOnTicks = wearFile->onTicks[i][j];
+                        }
+                    }
+                }
+                for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+                    for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+                        uint64_t drop = maxOnTicks == 0 ? 0 :
+                                        (LED_BRIGHTNESS_MAX - WEAR_MIN_BRIGHTNESS) * wearFile->onTicks[i][j] / maxOnTicks;
+                        levels[i][j] = (uint8_t)(LED_BRIGHTNESS_MAX - drop);
+                    }
+                }
+                setLedBrightness(levels);
+                break;
+            }
+            default:
+                memset(levels, LED_BRIGHTNESS_MAX, sizeof(levels));
+                setLedBrightness(levels);
+                status = setLayoutOffset(0, 0);
+                break;
+        }
+    } while(0);
+    return status;
+}
+
+void wearGetStats(wear_stats_t *stats)
+{
+    if(stats != NULL) {
+        *stats = wearStats;
+    }
+}
@@ -0,0 +1,107 @@
+/** ********************************************************************************
+*@file ledWear.h
+*@date March 16th, 2026
+*@author julio.liriano (julio.liriano@gmail.com)
+*@brief Per-LED on-time accounting and burn-in leveling. Each sent frame is added to
+*       bit sliced counters (bit k of the counters of a whole row in one word), which
+*       are folded every minute into per-LED totals in a small memory-mapped file, so
+*       the totals survive restarts. A leveling policy uses the totals to shift the
+*       clock layout or dim the most worn LEDs.
+*
+********************************************************************************** */
+#ifndef __LEDWEAR_H
+#define __LEDWEAR_H
+/* Includes ------------------------------------------------------------------*/
+#include "ledMatrix.h"
+#include <stdint.h>
+#include <stdbool.h>
+/* Exported constants --------------------------------------------------------*/
+#define WEAR_TICK_MS 100                // On-time is counted in ticks of this length
+#define WEAR_SLICE_BITS 11              // Bits per counter, they are folded into the file before they can overflow
+#define WEAR_FLUSH_TICKS 600            // Counters are folded into the file at least this often (1 minute)
+#define WEAR_MIN_BRIGHTNESS 192         // Drive level of the most worn LED with the dim policy
+/* Exported macros -----------------------------------------------------------*/
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    WEAR_LEVEL_NONE = 0,    // Default layout at full brightness
+    WEAR_LEVEL_SHIFT,       // Shift the layout by a pixel to where the LEDs are least worn
+    WEAR_LEVEL_DIM,         // Lower the drive level of LEDs in proportion to their on-time
+    NUM_WEAR_POLICIES // should always be last
+} wear_policy_t;
+
+typedef struct {
+    uint64_t frames;        // Frames accounted
+    uint64_t ticks;         // Ticks of on-time accounted
+    uint64_t flushes;       // Times the counters were folded into the file
+    uint64_t flushNsec;     // Time spent folding
+    uint64_t maxFlushNsec;  // Longest fold
+} wear_stats_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Maps the wear file, creating it if needed, and starts accounting. Only a new (empty)
+ *        file is initialised, any other file must be a wear file for this panel size and tick
+ *        length and is never modified otherwise.
+ *
+ * @param path - Wear file path
+ * @return led_matrix_err_t - LED_IO_ERROR if the file can't be created or mapped, or is not
+ *                            a wear file for this panel.
+ */
+led_matrix_err_t wearOpen(const char *path);
+
+/**
+ * @brief Accounts the frame still on the panel up to now, folds the counters into the file, 
+ *        syncs and unmaps it. Accounting stops.
+ *
+ * @param tickNsec - Time of the close, on the same timeline as wearRecordFrame().
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t wearClose(uint64_t tickNsec);
+
+/**
+ * @brief Accounts a sent frame. The whole ticks passed since the previous frame was sent are
+ *        added to the LEDs lit in that frame, since it was on the panel until now. Does nothing
+ *        unless the wear file is open.
+ *
+ * @param rows - Packed frame that was just sent.
+ * @param tickNsec - Time it was sent, on a real time monotonic timeline (e.g. getMonotonicNsec()).
+ */
+void wearRecordFrame(const matrix_row_t rows[MATRIX_HEIGHT], uint64_t tickNsec);
+
+/**
+ * @brief Folds the counters into the file.
+ *
+ * @return led_matrix_err_t - LED_ARG_ERROR if the wear file is not open.
+ */
+led_matrix_err_t wearFlush(void);
+
+/**
+ * @brief Gets the on-time of each LED and the running time of the panel, in ticks.
+ *
+ * @param onTicksOut - On-time of each LED
+ * @param totalTicksOut - Optional (may be NULL). Running time of the panel.
+ * @return led_matrix_err_t - LED_ARG_ERROR if the wear file is not open.
+ */
+led_matrix_err_t wearGetOnTime(uint64_t onTicksOut[MATRIX_HEIGHT][MATRIX_WIDTH], uint64_t *totalTicksOut);
+
+/**
+ * @brief Applies a leveling policy once, from the on-time so far. Shifting picks the layout
+ *        offset whose digit and colon cells have the least on-time, keeping the current one
+ *        on a tie. Dimming sets the drive level of each LED from LED_BRIGHTNESS_MAX (never lit)
+ *        down to WEAR_MIN_BRIGHTNESS (most worn).
+ *
+ * @param policy
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t wearApplyLeveling(wear_policy_t policy);
+
+/**
+ * @brief Gets the accounting statistics.
+ *
+ * @param stats - Output statistics.
+ */
+void wearGetStats(wear_stats_t *stats);
+#endif /* __LEDWEAR_H */
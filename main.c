@@ -15,7 +15,18 @@
 /* Includes ------------------------------------------------------------------*/
 #include "ledMatrix.h"
 #include "timeFuncs.h"
+#include "frameExport.h"
+#include "scanRefresh.h"
+#include "compositor.h"
+#include "controlServer.h"
+#include "matrixTransform.h"
+#include "trace.h"
+#include "worldClock.h"
+#include "animator.h"
+#include "palette.h"
+#include "ledWear.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
@@ -36,25 +47,160 @@
 /* Private constants ---------------------------------------------------------*/
 #define ALARM_DISPLAY_DURATION_MS 2000 // Duration to display the alarm time in milliseconds
 #define DIGIT_DISPLAY_DURATION_MS 5000 // Duration to display a single digit in milliseconds
+#define FRAME_PERIOD_MS 100 // Main loop update period in milliseconds
+#define TIMER_FRAME_PERIOD_MS 10 // Update period while showing the stopwatch or countdown (100 Hz)
+#define COUNTDOWN_DEFAULT_MS 60000 // Countdown started by the 'c' button
+#define DEFAULT_EXPORT_SCALE 8 // Default number of video pixels per LED when exporting frames
+#define DEFAULT_ALARM_HOUR 5 // Alarm time set by the 'A' button (24-hour)
+#define DEFAULT_ALARM_MINUTE 30
+#define WORLD_ZONE_DURATION_MS 3000 // Time each zone is shown in the world clock, the label comes first
+#define WORLD_LABEL_DURATION_MS 1000
+#define NSEC_PER_MIN (60ULL * NSEC_PER_SEC)
+#define LATCH_LATENCY_BUCKETS 10000 // 1 usec buckets for the rollover to send latency, anything later lands in the last bucket
+#define WEAR_LEVEL_PERIOD_MS 3600000 // Leveling is re-applied every hour (of clock time)
+#define WORLD_CLOCK_REFRESH_PERIOD_MS 3600000 // The world clock tables are checked every hour (of clock time)
+#define DEFAULT_WORLD_ZONES "America/Los_Angeles=LA,America/New_York=NYC,Europe/London=LON,Asia/Tokyo=TOKY"
 /* Private macros ------------------------------------------------------------*/
 
 /* Private types -------------------------------------------------------------*/
 
+// Frame pacing statistics for the main loop
+typedef struct {
+    uint64_t frames;
+    uint64_t lateFrames;     // Woke up more than half a period after the deadline
+    uint64_t droppedFrames;  // Deadlines skipped entirely because the loop fell behind
+} frame_pacing_t;
+
+// Latency from the wall clock minute rollover to the pre-rendered frame being sent
+typedef struct {
+    uint64_t latches;
+    uint64_t abandoned;      // The wall clock moved the rollover past the next frame deadline while waiting
+    uint64_t totalNsec;
+    uint64_t maxNsec;
+    uint32_t histogram[LATCH_LATENCY_BUCKETS];
+} latch_stats_t;
+
+// Command line options
+typedef struct {
+    const char *exportPath;         // -o : Stream frames to this file ("-" for stdout)
+    export_format_t exportFormat;   // -f : y4m or ppm
+    uint8_t exportScale;            // -s : Video pixels per LED
+    uint32_t timeScale;             // -x : Time acceleration factor
+    uint64_t runDurationMs;         // -d : Stop after this many (accelerated) seconds, 0 runs until quit
+    uint32_t scanRowRateHz;         // -r : Run the scan refresh thread at this many rows per second, 0 disables it
+    int scanCpu;                    // -c : Core to pin the scan refresh thread to
+    const char *controlPath;        // -u : Listen for control commands on this Unix-domain socket
+    output_transform_t transform;   // -R : Rotation (0/90/180/270), -M : Mirror (h, v or hv), -Z : Panel upscale
+    const char *tracePath;          // -T : Record a trace and write it to this file as Chrome trace JSON on exit
+    const char *worldZones;         // -W : Zones shown by the world clock, "Zone[=LABEL],...", NULL uses the defaults
+    transition_t transition;        // -A : Digit transition animation (none, slide, roll or fade)
+    const char *theme;              // -P : Color theme (classic, contrast or night)
+    const char *wearPath;           // -E : Account the on-time of each LED in this file, kept across runs
+    wear_policy_t wearPolicy;       // -L : Wear leveling policy (none, shift or dim), needs -E
+} clock_options_t;
+
 // State machine states for what to display on the LED matrix
 typedef enum {
     DISPLAY_TIME = 0,
     DISPLAY_ALARM_TIME = 1, 
-    DISPLAY_DIGIT = 2
+    DISPLAY_DIGIT = 2,
+    DISPLAY_FRAME = 3, // Frame pushed over the control socket
+    DISPLAY_STOPWATCH = 4,
+    DISPLAY_COUNTDOWN = 5,
+    DISPLAY_WORLD_CLOCK = 6,
+    NUM_DISPLAY_STATES // should always be last
 } display_state_t;
 
+// Requests to the render loop from other threads, and the state it shows (see controlLock)
+typedef struct {
+    display_state_t state;          // Display switch, NUM_DISPLAY_STATES when none is pending
+    bool isAlarmPending;            // Alarm set/clear waiting to be applied
+    bool isAlarmSet;
+    uint8_t alarmHour;
+    uint8_t alarmMinute;
+    bool isFramePending;            // Frame pushed since the render loop last took one
+    matrix_row_t frame[MATRIX_HEIGHT];
+    ctrl_state_t shown;             // Published by the render loop every frame
+} control_shared_t;
+
 /* Private variables ---------------------------------------------------------*/
 static struct tm localTime;
 static bool isQuit = false; // Flag to signal the input thread to exit
 static bool isAlarmSet = false; // Flag to track if the alarm is set or not
+static uint8_t alarmHour = DEFAULT_ALARM_HOUR; // Alarm time (24-hour)
+static uint8_t alarmMinute = DEFAULT_ALARM_MINUTE;
 static bool isDisplayAlarm = false; // Flag to track whether we are currently displaying the alarm time or not.
 static bool isDisplayDigit = false; // Flag to track whether we are currently displaying a single digit for testing purposes.   
 static uint8_t buttonCnt = 0; // Counter to track the number of button presses for testing purposes.
+static bool isStopwatchToggle = false; // Flag to start/pause the stopwatch (and show it)
+static bool isStopwatchReset = false; // Flag to reset the stopwatch to zero
+static bool isCountdownStart = false; // Flag to (re)start the countdown (and show it)
+static bool isExitTimer = false; // Flag to go from the stopwatch/countdown back to the clock
+static bool isTraceToggle = false; // Flag to pause/resume tracing
+static bool isWorldClockStart = false; // Flag to show the world clock
+static uint64_t worldClockStartTick = 0; // Tick when the world clock was started, zones cycle from here
+static bool isStopwatchRunning = false;
+static uint64_t stopwatchStartNsec = 0; // Tick when the stopwatch was last started
+static uint64_t stopwatchElapsedNsec = 0; // Time accumulated before the stopwatch was last paused
+static uint64_t countdownStartNsec = 0; // Tick when the countdown was started
+static frame_pacing_t timerPacing = {0}; // Pacing of the 100 Hz stopwatch/countdown frames
+static latch_stats_t latchStats = {0}; // Minute rollover latency
+static frame_pacing_t animationPacing = {0}; // Pacing of the 60 Hz digit animation frames
+static bool isWearAccounting = false; // Sent frames add to the LED on-time (real time runs only)
 static display_state_t clockState = DISPLAY_TIME;
+static clock_options_t options = {
+    .exportPath = NULL,
+    .exportFormat = EXPORT_FORMAT_Y4M,
+    .exportScale = DEFAULT_EXPORT_SCALE,
+    .timeScale = 1,
+    .runDurationMs = 0,
+    .scanRowRateHz = 0,
+    .scanCpu = SCAN_NO_CPU,
+    .controlPath = NULL,
+    .transform = {.rotation = ROTATE_0, .isMirrorH = false, .isMirrorV = false, .scale = 1},
+    .tracePath = NULL,
+    .worldZones = NULL,
+    .transition = TRANSITION_NONE,
+    .theme = "classic",
+    .wearPath = NULL,
+    .wearPolicy = WEAR_LEVEL_NONE
+};
+
+// Values of the -A option
+static const char *transitionNames[NUM_TRANSITIONS] = {
+    [TRANSITION_NONE] = "none",
+    [TRANSITION_SLIDE] = "slide",
+    [TRANSITION_ROLL] = "roll",
+    [TRANSITION_FADE] = "fade"
+};
+
+// Names of the wear leveling policies, as given to -L
+static const char *wearPolicyNames[NUM_WEAR_POLICIES] = {
+    [WEAR_LEVEL_NONE] = "none",
+    [WEAR_LEVEL_SHIFT] = "shift",
+    [WEAR_LEVEL_DIM] = "dim"
+};
+
+// Names of the state transition events in the trace
+static const char *stateTraceNames[NUM_DISPLAY_STATES] = {
+    [DISPLAY_TIME] = "state: time",
+    [DISPLAY_ALARM_TIME] = "state: alarm time",
+    [DISPLAY_DIGIT] = "state: digit",
+    [DISPLAY_FRAME] = "state: pushed frame",
+    [DISPLAY_STOPWATCH] = "state: stopwatch",
+    [DISPLAY_COUNTDOWN] = "state: countdown",
+    [DISPLAY_WORLD_CLOCK] = "state: world clock"
+};
+
+// State shared with the control socket and input threads, only touched with controlLock held. The 
+// render loop picks up the requests once per frame and publishes what it shows for queries.
+static pthread_mutex_t controlLock = PTHREAD_MUTEX_INITIALIZER;
+static control_shared_t control = {
+    .state = NUM_DISPLAY_STATES,
+    .isAlarmPending = false,
+    .isFramePending = false,
+    .shown = {.mode = DISPLAY_TIME, .alarmHour = DEFAULT_ALARM_HOUR, .alarmMinute = DEFAULT_ALARM_MINUTE}
+};
 /* Private functions ---------------------------------------------------------*/
 
 /**
@@ -74,28 +220,123 @@ static void processButtonPress(char button);
 static void *input_thread(void *ptr); 
 
 /**
- * @brief Sets the characters on the LED matrix to display the time based on the provided tm structure.
+ * @brief Draws the time into the time layer based on the provided tm structure. Digits that changed 
+ *        go through the selected transition animation.
  * 
  * @param timeInfo - Pointer to a tm structure that contains the time information to be displayed.
+ * @param tickNsec - Time of the frame, animations are drawn as they are at this time.
  */
-static void setTimeDisplay(struct tm *timeInfo); 
+static void setTimeDisplay(struct tm *timeInfo, uint64_t tickNsec); 
 
 /**
- * @brief Display the alarm time on the LED matrix. 
+ * @brief Draws the status indicators (alarm dot) into the status layer.
+ * 
+ */
+static void setStatusDisplay(void);
+
+/**
+ * @brief Display the alarm time on the overlay layer, hiding the clock. 
  * 
  */
 static void setAlarmDisplay(void); 
 
 /**
- * @brief Sets a single digit character on the LED matrix.
+ * @brief Sets a single digit character on the overlay layer, hiding the clock.
  * 
  * @param digit - The digit (0-9) to be displayed on the LED matrix. 
  */
 static void setDigitDisplay(uint8_t digit); 
 
+/**
+ * @brief Draws a stopwatch/countdown time on the overlay layer, hiding the clock. Shows SS.cc 
+ *        under a minute and MM:SS from a minute up.
+ * 
+ * @param timeNsec - Time to display in nanoseconds.
+ */
+static void setTimerDisplay(uint64_t timeNsec);
+
+/**
+ * @brief Draws the world clock on the overlay layer, hiding the clock. Cycles through the zones, 
+ *        showing the label of each zone and then its time.
+ * 
+ * @param utc - Current time in seconds since the epoch
+ * @param elapsedMs - Time since the world clock was started
+ */
+static void setWorldClockDisplay(time_t utc, uint64_t elapsedMs);
+
+/**
+ * @brief Sends the LED matrix frame to the panel, hands it to the scan refresh thread and 
+ *        accounts the on-time of its LEDs.
+ * 
+ */
+static void sendFrame(void);
+
+/**
+ * @brief Renders the next minute into a back buffer, then sleeps until the wall clock rolls over 
+ *        and swaps it in and sends it. Records the rollover to send latency.
+ * 
+ * @param rolloverNsec - Start of the next minute, on the getEpochNsec() timeline.
+ * @param deadlineNsec - Next frame deadline (getTickNsec() timeline). If the wall clock is stepped 
+ *                       and the rollover moves past it, the latch is given up and the regular 
+ *                       frame shows the time.
+ * @param isPrint - Also print the frame to the terminal after sending it.
+ * @return true - The next minute was sent.
+ * @return false - Gave up waiting for the rollover.
+ */
+static bool latchNextMinute(uint64_t rolloverNsec, uint64_t deadlineNsec, bool isPrint);
+
+/**
+ * @brief Gets a percentile of the rollover to send latency from the histogram.
+ * 
+ * @param percentile - 0 to 1
+ * @return uint64_t - Latency in nanoseconds (1 usec resolution).
+ */
+static uint64_t getLatchPercentileNsec(double percentile);
+
+/**
+ * @brief Hands an alarm set/clear to the render loop, which applies it on the next frame.
+ * 
+ */
+static void requestAlarm(bool isSet, uint8_t hour, uint8_t minute);
+
+/**
+ * @brief Control socket handler. Sets or clears the alarm.
+ * 
+ */
+static led_matrix_err_t controlSetAlarm(bool isSet, uint8_t hour, uint8_t minute);
+
+/**
+ * @brief Control socket handler. Requests a switch to another display state.
+ * 
+ */
+static led_matrix_err_t controlSetMode(uint8_t mode);
+
+/**
+ * @brief Control socket handler. Reports the current state of the clock.
+ * 
+ */
+static void controlGetState(ctrl_state_t *state);
+
+/**
+ * @brief Control socket handler. Stores a pushed frame and switches to showing it.
+ * 
+ */
+static led_matrix_err_t controlPushFrame(const matrix_row_t rows[MATRIX_HEIGHT]);
+
+/**
+ * @brief Parses the command line options into the options structure.
+ * 
+ * @param argc - Argument count from main
+ * @param argv - Argument vector from main
+ * @return true - Options are valid
+ * @return false - Invalid option, usage was printed
+ */
+static bool parseOptions(int argc, char *argv[]);
+
 /* Definitions ---------------------------------------------------------------*/
 static void processButtonPress(char button)
 {
+    TRACE_BEGIN("processButtonPress");
     switch(button) {
         case 'q': // Quit on 'q' key press
         case 'Q':
@@ -103,10 +344,10 @@ static void processButtonPress(char button)
             isQuit = true;
             break;
         case 'a': // lower case 'a' will clear the alarm. 
-            isAlarmSet = false;
+            requestAlarm(false, 0, 0);
             break;
-        case 'A': // Upper case 'A' will set the alarm.
-            isAlarmSet = true;
+        case 'A': // Upper case 'A' will set the alarm to the default alarm time.
+            requestAlarm(true, DEFAULT_ALARM_HOUR, DEFAULT_ALARM_MINUTE);
             break;
         case 'd':
         case 'D':
@@ -120,6 +361,27 @@ static void processButtonPress(char button)
             // Set flag to display a single digit for testing purposes.             
             isDisplayDigit = true;
             break;
+        case 's': // Lower case 's' shows the stopwatch and starts/pauses it.
+            isStopwatchToggle = true;
+            break;
+        case 'S': // Upper case 'S' resets the stopwatch.
+            isStopwatchReset = true;
+            break;
+        case 'c': // Lower case 'c' starts the countdown.
+            isCountdownStart = true;
+            break;
+        case 'x':
+        case 'X':
+            // Intentional fall-through. 
+            // Leave the stopwatch/countdown/world clock and show the clock again.
+            isExitTimer = true;
+            break;
+        case 'w': // Lower case 'w' shows the world clock, starting from the first zone (if any zones loaded).
+            isWorldClockStart = true;
+            break;
+        case 't': // Lower case 't' pauses/resumes tracing (only when a trace file was given).
+            isTraceToggle = true;
+            break;
         default:
             break;
     }
@@ -128,6 +390,7 @@ static void processButtonPress(char button)
     if(buttonCnt > 10) {
         buttonCnt = 0;
     }
+    TRACE_END("processButtonPress");
 }
 
 // Strictly for making getting input from the user non-blocking. 
@@ -136,6 +399,9 @@ static void processButtonPress(char button)
 void *input_thread(void *ptr) {
     char button = 0; 
     
+    if(options.tracePath != NULL) {
+        traceSetThreadName("input");
+    }
     while(!isQuit) {
         button = _getch(); // Read a single character from stdin
         processButtonPress(button); // Process the button press (e.g., toggle alarm dot)
@@ -144,11 +410,20 @@ void *input_thread(void *ptr) {
     return NULL;
 }
 #else
+// Restores the terminal settings. Runs on normal exit and when the thread is cancelled.
+static void restoreTerminal(void *oldt) {
+    tcsetattr(STDIN_FILENO, TCSANOW, (struct termios *)oldt);
+}
+
 void *input_thread(void *ptr) {
     char button = 0; 
     struct termios oldt, newt;
     ssize_t bytesRead = 0;
 
+    if(options.tracePath != NULL) {
+        traceSetThreadName("input");
+    }
+
     // Get current terminal settings and save them
     tcgetattr(STDIN_FILENO, &oldt);
 
@@ -159,125 +434,586 @@ void *input_thread(void *ptr) {
     // Apply the new settings immediately
     tcsetattr(STDIN_FILENO, TCSANOW, &newt);
 
+    // The main loop cancels this thread (blocked in read()) when it quits on its own
+    pthread_cleanup_push(restoreTerminal, &oldt);
     while(!isQuit) {
         bytesRead = read(STDIN_FILENO, &button, 1); // Read a single character from stdin
         if(bytesRead > 0) {
             processButtonPress(button); // Process the button press (e.g., toggle alarm dot)
+        } else if(bytesRead == 0) {
+            break; // stdin closed (e.g. redirected from a file), no more button presses
         }
     }
 
     // Restore the old terminal settings before exiting the thread
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+    pthread_cleanup_pop(1);
 
     return NULL;
 }
 #endif
 
-static void setTimeDisplay(struct tm *timeInfo) {
-    // Set the time characters at the specified positions
-    setCharacterAtPosition(timeInfo->tm_hour / 10, POS1);
-    setCharacterAtPosition(timeInfo->tm_hour % 10, POS2);
-    setCharacterAtPosition(COLON_CHAR, COLON);
-    setCharacterAtPosition(timeInfo->tm_min / 10, POS3);
-    setCharacterAtPosition(timeInfo->tm_min % 10, POS4);
+static void setTimeDisplay(struct tm *timeInfo, uint64_t tickNsec) {
+    matrix_row_t rows[MATRIX_HEIGHT] = {0};
+    matrix_row_t coverage[MATRIX_HEIGHT] = {0};
 
+    // Set the time characters at the specified positions. The animator keeps track of what each 
+    // position showed before and draws the transition while one is running.
+    animatorSetCharacter(POS1, timeInfo->tm_hour / 10, tickNsec);
+    animatorSetCharacter(POS2, timeInfo->tm_hour % 10, tickNsec);
+    animatorSetCharacter(POS3, timeInfo->tm_min / 10, tickNsec);
+    animatorSetCharacter(POS4, timeInfo->tm_min % 10, tickNsec);
+    animatorRender(tickNsec, rows, coverage);
+    setCharacterInRows(COLON_CHAR, COLON, rows, coverage);
+    layerSetRows(LAYER_TIME, rows, coverage);
+}
+
+static void setStatusDisplay(void) {
     // Set the alarm dot based on the isAlarmSet flag
+    layerClear(LAYER_STATUS);
     if(isAlarmSet) {
-        setCharacterAtPosition(ALARM_CHAR_SET, ALARM_DOT);
+        layerSetCharacter(LAYER_STATUS, ALARM_CHAR_SET, ALARM_DOT);
     } else {
-        setCharacterAtPosition(ALARM_CHAR_CLR, ALARM_DOT);
+        layerSetCharacter(LAYER_STATUS, ALARM_CHAR_CLR, ALARM_DOT);
     }
 }
 
 static void setAlarmDisplay(void)
 {
+    // Same 12-hour format as the clock
+    uint8_t hour = alarmHour > 12 ? alarmHour - 12 : alarmHour;
+
+    // Blank overlay covering the whole clock
+    layerFill(LAYER_OVERLAY, false);
+    layerSetVisible(LAYER_OVERLAY, true);
+
     if(isAlarmSet) {
-        // Display example alarm time of 5:30 am. 
-        setCharacterAtPosition(FIVE_CHAR, POS2);
-        setCharacterAtPosition(COLON_CHAR, COLON);
-        setCharacterAtPosition(THREE_CHAR, POS3);
-        setCharacterAtPosition(ZERO_CHAR, POS4);
+        // Display the alarm time (e.g. 5:30), leading zero of the hour is left blank. 
+        if(hour >= 10) {
+            layerSetCharacter(LAYER_OVERLAY, hour / 10, POS1);
+        }
+        layerSetCharacter(LAYER_OVERLAY, hour % 10, POS2);
+        layerSetCharacter(LAYER_OVERLAY, COLON_CHAR, COLON);
+        layerSetCharacter(LAYER_OVERLAY, alarmMinute / 10, POS3);
+        layerSetCharacter(LAYER_OVERLAY, alarmMinute % 10, POS4);
 
-        setCharacterAtPosition(ALARM_CHAR_SET, ALARM_DOT);
+        layerSetCharacter(LAYER_OVERLAY, ALARM_CHAR_SET, ALARM_DOT);
     }
     else {
-        setCharacterAtPosition(DASH_CHAR, POS1);
-        setCharacterAtPosition(DASH_CHAR, POS2);
-        setCharacterAtPosition(COLON_CHAR, COLON);
-        setCharacterAtPosition(DASH_CHAR, POS3);
-        setCharacterAtPosition(DASH_CHAR, POS4);
+        layerSetCharacter(LAYER_OVERLAY, DASH_CHAR, POS1);
+        layerSetCharacter(LAYER_OVERLAY, DASH_CHAR, POS2);
+        layerSetCharacter(LAYER_OVERLAY, COLON_CHAR, COLON);
+        layerSetCharacter(LAYER_OVERLAY, DASH_CHAR, POS3);
+        layerSetCharacter(LAYER_OVERLAY, DASH_CHAR, POS4);
 
-        setCharacterAtPosition(ALARM_CHAR_CLR, ALARM_DOT);
+        layerSetCharacter(LAYER_OVERLAY, ALARM_CHAR_CLR, ALARM_DOT);
     }
 }
 
 static void setDigitDisplay(uint8_t digit) {
-    // For testing purposes, we can set a single digit (e.g., '5') at POS1
+    // For testing purposes, we can set a single digit (e.g., '5') at POS4 on a blank overlay
+    layerFill(LAYER_OVERLAY, false);
+    layerSetVisible(LAYER_OVERLAY, true);
+
     digit = digit % 10; // Ensure the input is a single digit (0-9)
-    switch(digit) {
-        case 0:
-            setCharacterAtPosition(ZERO_CHAR, POS4);
-            break;
-        case 1:
-            setCharacterAtPosition(ONE_CHAR, POS4);
-            break;
-        case 2:
-            setCharacterAtPosition(TWO_CHAR, POS4);
-            break;
-        case 3:
-            setCharacterAtPosition(THREE_CHAR, POS4);
-            break;
-        case 4:
-            setCharacterAtPosition(FOUR_CHAR, POS4);
-            break;
-        case 5:
-            setCharacterAtPosition(FIVE_CHAR, POS4);
-            break;
-        case 6:
-            setCharacterAtPosition(SIX_CHAR, POS4);
-            break;
-        case 7:
-            setCharacterAtPosition(SEVEN_CHAR, POS4);
-            break;
-        case 8:
-            setCharacterAtPosition(EIGHT_CHAR, POS4);
-            break;
-        case 9:
-            setCharacterAtPosition(NINE_CHAR, POS4);
-            break;
-        default:
-            // If the input is not a valid digit, we can choose to clear the position or do nothing
-            // For this example, let's clear the position by setting it to a blank character (e.g., DASH)
-            setCharacterAtPosition(DASH_CHAR, POS4);
+    // Digits map directly onto ZERO_CHAR to NINE_CHAR
+    layerSetCharacter(LAYER_OVERLAY, (character_t)(ZERO_CHAR + digit), POS4);
+}
+
+static void setTimerDisplay(uint64_t timeNsec)
+{
+    uint64_t centiseconds = timeNsec / (10 * NSEC_PER_MSEC);
+    uint64_t seconds = centiseconds / 100;
+
+    layerFill(LAYER_OVERLAY, false);
+    layerSetVisible(LAYER_OVERLAY, true);
+
+    if(seconds < 60) {
+        // SS.cc
+        layerSetCharacter(LAYER_OVERLAY, (character_t)(seconds / 10), POS1);
+        layerSetCharacter(LAYER_OVERLAY, (character_t)(seconds % 10), POS2);
+        layerSetCharacter(LAYER_OVERLAY, DOT_CHAR, COLON);
+        layerSetCharacter(LAYER_OVERLAY, (character_t)((centiseconds % 100) / 10), POS3);
+        layerSetCharacter(LAYER_OVERLAY, (character_t)(centiseconds % 10), POS4);
+    } else {
+        // MM:SS, minutes wrap at 100
+        uint64_t minutes = (seconds / 60) % 100;
+        layerSetCharacter(LAYER_OVERLAY, (character_t)(minutes / 10), POS1);
+        layerSetCharacter(LAYER_OVERLAY, (character_t)(minutes % 10), POS2);
+        layerSetCharacter(LAYER_OVERLAY, COLON_CHAR, COLON);
+        layerSetCharacter(LAYER_OVERLAY, (character_t)((seconds % 60) / 10), POS3);
+        layerSetCharacter(LAYER_OVERLAY, (character_t)(seconds % 10), POS4);
+    }
+}
+
+static void setWorldClockDisplay(time_t utc, uint64_t elapsedMs)
+{
+    uint16_t zoneCount = worldClockGetZoneCount();
+    uint16_t zone = 0;
+    world_time_t zoneTime = {0};
+    character_t label[WORLD_LABEL_CHARS];
+
+    layerFill(LAYER_OVERLAY, false);
+    layerSetVisible(LAYER_OVERLAY, true);
+    if(zoneCount == 0) {
+        return;
+    }
+
+    zone = (uint16_t)((elapsedMs / WORLD_ZONE_DURATION_MS) % zoneCount);
+    if(elapsedMs % WORLD_ZONE_DURATION_MS < WORLD_LABEL_DURATION_MS) {
+        // Label letters go on the digit positions
+        static const char_pos_t labelPositions[WORLD_LABEL_CHARS] = {POS1, POS2, POS3, POS4};
+        worldClockGetLabel(zone, label);
+        for(uint8_t i = 0; i < WORLD_LABEL_CHARS; i++) {
+            if(label[i] != NUM_CHARACTERS) {
+                layerSetCharacter(LAYER_OVERLAY, label[i], labelPositions[i]);
+            }
+        }
+    } else {
+        // Same 12-hour format as the clock
+        worldClockGetTime(zone, utc, &zoneTime);
+        uint8_t hour = zoneTime.hour > 12 ? zoneTime.hour - 12 : zoneTime.hour;
+        layerSetCharacter(LAYER_OVERLAY, (character_t)(hour / 10), POS1);
+        layerSetCharacter(LAYER_OVERLAY, (character_t)(hour % 10), POS2);
+        layerSetCharacter(LAYER_OVERLAY, COLON_CHAR, COLON);
+        layerSetCharacter(LAYER_OVERLAY, (character_t)(zoneTime.minute / 10), POS3);
+        layerSetCharacter(LAYER_OVERLAY, (character_t)(zoneTime.minute % 10), POS4);
+    }
+}
+
+static void sendFrame(void)
+{
+    matrix_row_t rows[MATRIX_HEIGHT];
+
+    sendMatrix();
+    getMatrixRows(rows);
+
+    // The refresh thread latches it at the start of its next scan
+    if(options.scanRowRateHz != 0) {
+        scanRefreshPublishFrame(rows);
+    }
+    // On-time is real time on the panel, not the (possibly accelerated) tick timeline
+    if(isWearAccounting) {
+        wearRecordFrame(rows, getMonotonicNsec(TICK_SOURCE_PRECISE));
+    }
+}
+
+static bool latchNextMinute(uint64_t rolloverNsec, uint64_t deadlineNsec, bool isPrint)
+{
+    matrix_row_t backBuffer[MATRIX_HEIGHT];
+    matrix_row_t backColors[COLOR_BITS][MATRIX_HEIGHT];
+    struct tm nextTime;
+    uint64_t latencyNsec = 0;
+
+    // The layers hold the next minute from here on, the LED matrix keeps the current one until the swap
+    TRACE_BEGIN("prerender");
+    getTimeAt((time_t)(rolloverNsec / NSEC_PER_SEC), &nextTime);
+    setTimeDisplay(&nextTime, getTickNsec() + (rolloverNsec - getEpochNsec()));
+    setStatusDisplay();
+    compositeLayersToRows(backBuffer, backColors);
+    TRACE_END("prerender");
+
+    if(!sleepUntilEpochNsec(rolloverNsec, deadlineNsec)) {
+        latchStats.abandoned++;
+        TRACE_INSTANT("latch abandoned");
+        return false;
+    }
+
+    TRACE_BEGIN("latch");
+    setMatrixRows(backBuffer);
+    setMatrixColors(backColors);
+    sendFrame();
+    latencyNsec = getEpochNsec() - rolloverNsec;
+    TRACE_END("latch");
+
+    // Accelerated latencies are not meaningful
+    if(options.timeScale == 1) {
+        uint64_t bucket = latencyNsec / 1000;
+        latchStats.latches++;
+        latchStats.totalNsec += latencyNsec;
+        if(latencyNsec > latchStats.maxNsec) {
+            latchStats.maxNsec = latencyNsec;
+        }
+        latchStats.histogram[bucket < LATCH_LATENCY_BUCKETS ? bucket : LATCH_LATENCY_BUCKETS - 1]++;
+    }
+
+    if(isPrint) {
+        printMatrix();
+    }
+    return true;
+}
+
+static uint64_t getLatchPercentileNsec(double percentile)
+{
+    uint64_t target = (uint64_t)(percentile * (double)latchStats.latches);
+    uint64_t count = 0;
+
+    for(uint32_t i = 0; i < LATCH_LATENCY_BUCKETS; i++) {
+        count += latchStats.histogram[i];
+        if(count > target) {
+            return (uint64_t)i * 1000;
+        }
+    }
+    return latchStats.maxNsec;
+}
+
+static void requestAlarm(bool isSet, uint8_t hour, uint8_t minute)
+{
+    pthread_mutex_lock(&controlLock);
+    control.isAlarmPending = true;
+    control.isAlarmSet = isSet;
+    if(isSet) {
+        control.alarmHour = hour;
+        control.alarmMinute = minute;
+    }
+    pthread_mutex_unlock(&controlLock);
+}
+
+static led_matrix_err_t controlSetAlarm(bool isSet, uint8_t hour, uint8_t minute)
+{
+    if(isSet && (hour > 23 || minute > 59)) {
+        return LED_ARG_ERROR;
+    }
+    requestAlarm(isSet, hour, minute);
+    return LED_OK;
+}
+
+static led_matrix_err_t controlSetMode(uint8_t mode)
+{
+    if(mode >= NUM_DISPLAY_STATES || (mode == DISPLAY_WORLD_CLOCK && worldClockGetZoneCount() == 0)) {
+        return LED_ARG_ERROR;
+    }
+    TRACE_INSTANT("control: set mode");
+    pthread_mutex_lock(&controlLock);
+    control.state = (display_state_t)mode;
+    pthread_mutex_unlock(&controlLock);
+    return LED_OK;
+}
+
+static void controlGetState(ctrl_state_t *state)
+{
+    pthread_mutex_lock(&controlLock);
+    *state = control.shown;
+
+    // Requests not picked up yet are answered as they will be shown, so a query right after a 
+    // command sees its effect
+    if(control.state != NUM_DISPLAY_STATES) {
+        state->mode = (uint8_t)control.state;
+    }
+    if(control.isAlarmPending) {
+        state->isAlarmSet = control.isAlarmSet;
+        state->alarmHour = control.isAlarmSet ? control.alarmHour : state->alarmHour;
+        state->alarmMinute = control.isAlarmSet ? control.alarmMinute : state->alarmMinute;
+    }
+    pthread_mutex_unlock(&controlLock);
+}
+
+static led_matrix_err_t controlPushFrame(const matrix_row_t rows[MATRIX_HEIGHT])
+{
+    // Copied from the socket receive buffer once here, and once more into the overlay when the 
+    // render loop takes it. Frames pushed in between replace it and are never copied again.
+    TRACE_INSTANT("control: push frame");
+    pthread_mutex_lock(&controlLock);
+    memcpy(control.frame, rows, sizeof(control.frame));
+    control.isFramePending = true;
+    control.state = DISPLAY_FRAME;
+    pthread_mutex_unlock(&controlLock);
+    return LED_OK;
+}
+
+static bool parseOptions(int argc, char *argv[])
+{
+    bool isValid = true;
+
+    // Every option is a single letter followed by a value
+    for(int i = 1; i < argc && isValid; i += 2) {
+        if(argv[i][0] != '-' || strlen(argv[i]) != 2 || i + 1 >= argc) {
+            isValid = false;
             break;
+        }
+        const char *value = argv[i + 1];
+
+        switch(argv[i][1]) {
+            case 'o':
+                options.exportPath = value;
+                break;
+            case 'f':
+                if(strcmp(value, "y4m") == 0) {
+                    options.exportFormat = EXPORT_FORMAT_Y4M;
+                } else if(strcmp(value, "ppm") == 0) {
+                    options.exportFormat = EXPORT_FORMAT_PPM;
+                } else {
+                    isValid = false;
+                }
+                break;
+            case 's':
+                options.exportScale = (uint8_t)atoi(value);
+                break;
+            case 'x':
+                options.timeScale = (uint32_t)strtoul(value, NULL, 10);
+                break;
+            case 'd':
+                options.runDurationMs = strtoull(value, NULL, 10) * 1000ULL;
+                break;
+            case 'r':
+                options.scanRowRateHz = (uint32_t)strtoul(value, NULL, 10);
+                break;
+            case 'c':
+                options.scanCpu = atoi(value);
+                break;
+            case 'u':
+                options.controlPath = value;
+                break;
+            case 'R':
+                options.transform.rotation = (rotation_t)(atoi(value) / 90);
+                isValid = (atoi(value) % 90) == 0;
+                break;
+            case 'M':
+                options.transform.isMirrorH = strchr(value, 'h') != NULL;
+                options.transform.isMirrorV = strchr(value, 'v') != NULL;
+                break;
+            case 'Z':
+                options.transform.scale = (uint8_t)atoi(value);
+                break;
+            case 'T':
+                options.tracePath = value;
+                break;
+            case 'W':
+                options.worldZones = value;
+                break;
+            case 'P':
+                options.theme = value;
+                break;
+            case 'A':
+                options.transition = NUM_TRANSITIONS;
+                for(int t = 0; t < NUM_TRANSITIONS; t++) {
+                    if(strcmp(value, transitionNames[t]) == 0) {
+                        options.transition = (transition_t)t;
+                    }
+                }
+                isValid = options.transition != NUM_TRANSITIONS;
+                break;
+            case 'E':
+                options.wearPath = value;
+                break;
+            case 'L':
+                options.wearPolicy = NUM_WEAR_POLICIES;
+                for(int p = 0; p < NUM_WEAR_POLICIES; p++) {
+                    if(strcmp(value, wearPolicyNames[p]) == 0) {
+                        options.wearPolicy = (wear_policy_t)p;
+                    }
+                }
+                isValid = options.wearPolicy != NUM_WEAR_POLICIES;
+                break;
+            default:
+                isValid = false;
+                break;
+        }
+    }
+
+    // Leveling works from the on-time in the wear file
+    if(options.wearPolicy != WEAR_LEVEL_NONE && options.wearPath == NULL) {
+        isValid = false;
+    }
+
+    if(!isValid || options.timeScale == 0 || setOutputTransform(&options.transform) != LED_OK) {
+        printf("Usage: %s [-o file|-] [-f y4m|ppm] [-s pixelsPerLed] [-x timeScale] [-d seconds] [-r scanRowsPerSec] [-c scanCpu] [-u controlSocket] [-R rotation] [-M h|v|hv] [-Z panelScale] [-T traceFile] [-W zone[=LABEL],...] [-A none|slide|roll|fade] [-P classic|contrast|night] [-E wearFile] [-L none|shift|dim]\n", argv[0]);
+        return false;
     }
+    return true;
 }
 
-int main(void) {
+int main(int argc, char *argv[]) {
     pthread_t getInputThread;
     int threadStatus = 0;
     uint64_t stateTimer = 0; 
+    uint64_t frameDeadlineNsec = 0;
+    uint64_t framePeriodNsec = FRAME_PERIOD_MS * NSEC_PER_MSEC;
+    uint64_t wearLevelNsec = WEAR_LEVEL_PERIOD_MS * NSEC_PER_MSEC; // Next time the wear leveling is applied
+    uint64_t worldClockRefreshNsec = WORLD_CLOCK_REFRESH_PERIOD_MS * NSEC_PER_MSEC; // Next world clock table check
+    bool isExporting = false;
+    display_state_t tracedState = NUM_DISPLAY_STATES;
+    bool isAnimationFrame = false;
+
+    if(!parseOptions(argc, argv)) {
+        return -1;
+    }
+
+    // Tracing starts right away and can be paused with 't'
+    if(options.tracePath != NULL) {
+        traceSetThreadName("main");
+        traceSetEnabled(true);
+    }
+
+    if(options.exportPath != NULL) {
+        if(frameExportOpen(options.exportPath, options.exportFormat, options.exportScale, 1000 / FRAME_PERIOD_MS) != LED_OK) {
+            return -1;
+        }
+        isExporting = true;
+    }
+
+    // Frames of the digit transitions are computed once up front
+    animatorInit(options.transition);
+
+    // Clock, status and overlay each draw into their own layer. Only layers whose content 
+    // changed get blended again, so the time layer only costs a blend once a minute.
+    // The theme picks the palette and the color of each layer.
+    compositorInit();
+    if(paletteApplyTheme(options.theme) != LED_OK) {
+        return -1;
+    }
+
+    // Every sent frame adds to the on-time of its LEDs. Leveling moves the layout or dims LEDs
+    // from the on-time so far, before the first frame and then every hour. Accelerated or exported 
+    // runs don't reflect how long the panel was lit, they only use the file for leveling.
+    if(options.wearPath != NULL) {
+        if(wearOpen(options.wearPath) != LED_OK) {
+            return -1;
+        }
+        isWearAccounting = (options.timeScale == 1 && !isExporting);
+        if(!isWearAccounting) {
+            fprintf(stderr, "Wear accounting is off with -x or -o, %s is only used for leveling\n", options.wearPath);
+        }
+        wearApplyLeveling(options.wearPolicy);
+    }
+
+    // Load the world clock zones. Zones asked for with -W must load, 
+    // without the default ones only the world clock is lost.
+    if(worldClockLoadZones(options.worldZones != NULL ? options.worldZones : DEFAULT_WORLD_ZONES) != LED_OK) {
+        if(options.worldZones != NULL) {
+            return -1;
+        }
+        fprintf(stderr, "Warning: could not load the default world clock zones, the world clock ('w') is disabled\n");
+        worldClockClear();
+    }
 
     // Create a thread to manage user input
     threadStatus = pthread_create(&getInputThread, NULL, input_thread, NULL);
     if (threadStatus != 0) {
-        printf("Error creating input thread: %d\n", threadStatus);
+        fprintf(stderr, "Error creating input thread: %d\n", threadStatus);
         return -1; 
     }
 
-    // Initialize the tick counter
+    // Initialize the tick counter. The main loop sleeps to its frame deadlines and reads getTick() 
+    // only a few times per frame for the display timers, so the default precise clock costs nothing 
+    // noticeable and keeps getTick() consistent with the getTickNsec() frame timeline.
+    setTimeScale(options.timeScale);
     initTick();
 
+    // Start scanning the frame out row by row (no panel driver yet, so rows go to the null backend)
+    if(options.scanRowRateHz != 0) {
+        scan_config_t scanConfig = {
+            .rowRateHz = options.scanRowRateHz,
+            .cpu = options.scanCpu,
+            .priority = SCAN_DEFAULT_PRIORITY,
+            .isLockMemory = true
+        };
+        if(scanRefreshStart(&scanNullBackend, &scanConfig) != LED_OK) {
+            options.scanRowRateHz = 0;
+        }
+    }
+
+    // Take commands from other processes
+    if(options.controlPath != NULL) {
+        const ctrl_handlers_t handlers = {
+            .setAlarm = controlSetAlarm,
+            .setMode = controlSetMode,
+            .getState = controlGetState,
+            .pushFrame = controlPushFrame
+        };
+        if(controlServerStart(options.controlPath, &handlers) != LED_OK) {
+            options.controlPath = NULL;
+        }
+    }
+
     while(!isQuit) {
+        // Toggled between frames so begin/end events stay paired
+        if(isTraceToggle) {
+            isTraceToggle = false;
+            if(options.tracePath != NULL) {
+                traceSetEnabled(!traceIsEnabled);
+            }
+        }
+        TRACE_BEGIN("frame");
+
         // Get the current time
+        TRACE_BEGIN("getTime");
         getTime(&localTime);
+        TRACE_END("getTime");
 
-        // Initialize the LED matrix
-        clearMatrix();    
+        TRACE_BEGIN("render");
+        // Alarm changes, display switches and frames requested by the control socket and input threads
+        pthread_mutex_lock(&controlLock);
+        if(control.isAlarmPending) {
+            control.isAlarmPending = false;
+            isAlarmSet = control.isAlarmSet;
+            if(isAlarmSet) {
+                alarmHour = control.alarmHour;
+                alarmMinute = control.alarmMinute;
+            }
+        }
+        if(control.state != NUM_DISPLAY_STATES) {
+            // Other displays draw over the overlay, so switching back to the pushed frame redraws it
+            control.isFramePending |= (control.state == DISPLAY_FRAME && clockState != DISPLAY_FRAME);
+            clockState = control.state;
+            control.state = NUM_DISPLAY_STATES;
+            stateTimer = getTick();
+            worldClockStartTick = stateTimer;
+        }
+        if(control.isFramePending && clockState == DISPLAY_FRAME) {
+            control.isFramePending = false;
+            layerSetRows(LAYER_OVERLAY, control.frame, NULL);
+        }
+        pthread_mutex_unlock(&controlLock);
+
+        // The clock and status indicators are always drawn, the overlay hides them when needed
+        setTimeDisplay(&localTime, getTickNsec());
+        setStatusDisplay();
+
+        // Stopwatch and countdown buttons. The time shown is always computed from the monotonic 
+        // start tick, never accumulated per frame, so it does not drift.
+        if(isStopwatchToggle) {
+            isStopwatchToggle = false;
+            if(clockState != DISPLAY_STOPWATCH) {
+                clockState = DISPLAY_STOPWATCH;
+                if(!isStopwatchRunning) {
+                    isStopwatchRunning = true;
+                    stopwatchStartNsec = getTickNsec();
+                }
+            } else if(isStopwatchRunning) {
+                isStopwatchRunning = false;
+                stopwatchElapsedNsec += getTickNsec() - stopwatchStartNsec;
+            } else {
+                isStopwatchRunning = true;
+                stopwatchStartNsec = getTickNsec();
+            }
+        }
+        if(isStopwatchReset) {
+            isStopwatchReset = false;
+            stopwatchElapsedNsec = 0;
+            stopwatchStartNsec = getTickNsec();
+        }
+        if(isCountdownStart) {
+            isCountdownStart = false;
+            clockState = DISPLAY_COUNTDOWN;
+            countdownStartNsec = getTickNsec();
+        }
+        if(isWorldClockStart) {
+            isWorldClockStart = false;
+            if(worldClockGetZoneCount() != 0) {
+                clockState = DISPLAY_WORLD_CLOCK;
+                worldClockStartTick = getTick();
+            }
+        }
+        if(isExitTimer) {
+            isExitTimer = false;
+            if(clockState == DISPLAY_STOPWATCH || clockState == DISPLAY_COUNTDOWN || clockState == DISPLAY_WORLD_CLOCK) {
+                clockState = DISPLAY_TIME;
+            }
+        }
 
         switch(clockState) {
             case DISPLAY_TIME:
-                setTimeDisplay(&localTime);
+                layerSetVisible(LAYER_OVERLAY, false);
                 if(isDisplayAlarm) {
                     clockState = DISPLAY_ALARM_TIME;
                     stateTimer = getTick(); // Reset the timer when we switch to alarm display
@@ -303,22 +1039,234 @@ int main(void) {
                     clockState = DISPLAY_TIME;
                 }
                 break;
+            case DISPLAY_FRAME:
+                // Pushed frame (copied into the overlay when it was taken) stays up until another mode is selected
+                layerSetVisible(LAYER_OVERLAY, true);
+                break;
+            case DISPLAY_STOPWATCH:
+                setTimerDisplay(stopwatchElapsedNsec + (isStopwatchRunning ? getTickNsec() - stopwatchStartNsec : 0));
+                break;
+            case DISPLAY_COUNTDOWN: {
+                uint64_t countdownNsec = COUNTDOWN_DEFAULT_MS * NSEC_PER_MSEC;
+                uint64_t elapsedNsec = getTickNsec() - countdownStartNsec;
+                // Round up so the countdown shows 00.00 exactly when it runs out
+                uint64_t remainingNsec = elapsedNsec < countdownNsec ? countdownNsec - elapsedNsec + 10 * NSEC_PER_MSEC - 1 : 0;
+                setTimerDisplay(remainingNsec);
+                break;
+            }
+            case DISPLAY_WORLD_CLOCK:
+                setWorldClockDisplay(getEpochTime(), getTick() - worldClockStartTick);
+                break;
             default:
                 // Should never be here but force state to display clock
                 clockState = DISPLAY_TIME;
+                TRACE_END("render");
+                TRACE_END("frame");
                 continue;
                 break;
         }
 
-        // Print the LED matrix to the terminal for visualization
-        printMatrix();
+        if(clockState != tracedState) {
+            TRACE_INSTANT(stateTraceNames[clockState]);
+            tracedState = clockState;
+        }
+
+        // What this frame shows, for control socket queries
+        pthread_mutex_lock(&controlLock);
+        control.shown = (ctrl_state_t){
+            .mode = (uint8_t)clockState,
+            .isAlarmSet = isAlarmSet,
+            .alarmHour = alarmHour,
+            .alarmMinute = alarmMinute,
+            .hour = (uint8_t)localTime.tm_hour,
+            .minute = (uint8_t)localTime.tm_min
+        };
+        pthread_mutex_unlock(&controlLock);
+
+        // Blend the layers into the LED matrix frame and send it to the panel
+        compositeLayers();
+        TRACE_END("render");
+
+        TRACE_BEGIN("sendMatrix");
+        sendFrame();
+        TRACE_END("sendMatrix");
+
+        // The new layout or brightness shows from the next frame
+        if(options.wearPolicy != WEAR_LEVEL_NONE && getTickNsec() >= wearLevelNsec) {
+            TRACE_BEGIN("wearApplyLeveling");
+            wearApplyLeveling(options.wearPolicy);
+            TRACE_END("wearApplyLeveling");
+            wearLevelNsec += WEAR_LEVEL_PERIOD_MS * NSEC_PER_MSEC;
+        }
+
+        // Rebuild the world clock tables before their horizon runs out on long runs
+        if(getTickNsec() >= worldClockRefreshNsec) {
+            TRACE_BEGIN("worldClockRefresh");
+            worldClockRefresh(getEpochTime());
+            TRACE_END("worldClockRefresh");
+            worldClockRefreshNsec += WORLD_CLOCK_REFRESH_PERIOD_MS * NSEC_PER_MSEC;
+        }
 
-        // Update every 100 msec. 
-        delayMsec(100); 
+        if(isExporting) {
+            // Terminal preview is skipped while exporting, it would only slow down accelerated time 
+            // and would corrupt the stream when exporting to stdout. The video keeps the normal 
+            // frame rate, so only frames on the FRAME_PERIOD_MS grid are written.
+            TRACE_BEGIN("frameExportWrite");
+            if((frameDeadlineNsec % (FRAME_PERIOD_MS * NSEC_PER_MSEC)) == 0 && frameExportWrite() != LED_OK) {
+                fprintf(stderr, "Error writing exported frame\n");
+                isQuit = true;
+            }
+            TRACE_END("frameExportWrite");
+        } else {
+            // Print the LED matrix to the terminal for visualization
+            TRACE_BEGIN("printMatrix");
+            printMatrix();
+            TRACE_END("printMatrix");
+        }
+
+        // Update every 100 msec, or at 100 Hz for the stopwatch/countdown. Deadlines are absolute and on a grid 
+        // of the period, so frames do not drift and each exported frame covers exactly one period.
+        bool isTimerFrame = (clockState == DISPLAY_STOPWATCH || clockState == DISPLAY_COUNTDOWN);
+        uint64_t nowNsec = getTickNsec();
+        if(clockState == DISPLAY_TIME && !isExporting && animatorIsActive(nowNsec)) {
+            // While digits animate, run at 60 Hz on the grid of the transition start. Exported 
+            // video keeps its frame rate and samples the animation instead.
+            uint64_t nextNsec = animatorGetNextFrameNsec(nowNsec);
+            if(isAnimationFrame && nextNsec > frameDeadlineNsec + ANIM_FRAME_NSEC) {
+                animationPacing.droppedFrames += (nextNsec - frameDeadlineNsec) / ANIM_FRAME_NSEC - 1;
+            }
+            isAnimationFrame = true;
+            framePeriodNsec = ANIM_FRAME_NSEC;
+            frameDeadlineNsec = nextNsec;
+        } else {
+            isAnimationFrame = false;
+            framePeriodNsec = (isTimerFrame ? TIMER_FRAME_PERIOD_MS : FRAME_PERIOD_MS) * NSEC_PER_MSEC;
+            frameDeadlineNsec = (frameDeadlineNsec / framePeriodNsec + 1) * framePeriodNsec;
+        }
+
+        // If rendering overran one or more deadlines, those frames are dropped and we pick up at the next one
+        nowNsec = getTickNsec();
+        if(nowNsec >= frameDeadlineNsec) {
+            uint64_t missed = (nowNsec - frameDeadlineNsec) / framePeriodNsec + 1;
+            frameDeadlineNsec += missed * framePeriodNsec;
+            if(isTimerFrame) {
+                timerPacing.droppedFrames += missed;
+            } else if(isAnimationFrame) {
+                animationPacing.droppedFrames += missed;
+            }
+        }
+        if(options.runDurationMs != 0 && frameDeadlineNsec >= options.runDurationMs * NSEC_PER_MSEC) {
+            isQuit = true;
+        }
+
+        // Polling alone would show the new minute up to a frame period (plus render time) late. When the 
+        // rollover comes before the next deadline, the next minute is rendered ahead and sent right on it.
+        if(clockState == DISPLAY_TIME && !isQuit) {
+            uint64_t nowEpochNsec = getEpochNsec();
+            uint64_t rolloverNsec = (nowEpochNsec / NSEC_PER_MIN + 1) * NSEC_PER_MIN;
+            nowNsec = getTickNsec();
+            if(nowNsec < frameDeadlineNsec && rolloverNsec - nowEpochNsec < frameDeadlineNsec - nowNsec &&
+               latchNextMinute(rolloverNsec, frameDeadlineNsec, !isExporting)) {
+                // The latched frame started the digit transitions, continue them at 60 Hz from here
+                nowNsec = getTickNsec();
+                if(!isExporting && animatorIsActive(nowNsec)) {
+                    isAnimationFrame = true;
+                    framePeriodNsec = ANIM_FRAME_NSEC;
+                    frameDeadlineNsec = animatorGetNextFrameNsec(nowNsec);
+                }
+            }
+        }
+        TRACE_END("frame");
+
+        TRACE_BEGIN("sleep");
+        sleepUntilTickNsec(frameDeadlineNsec);
+        TRACE_END("sleep");
+
+        if(isTimerFrame || isAnimationFrame) {
+            frame_pacing_t *pacing = isTimerFrame ? &timerPacing : &animationPacing;
+            pacing->frames++;
+            // Signed, with a time scale the sleep rounds down and can wake a few nsec before the deadline
+            if((int64_t)(getTickNsec() - frameDeadlineNsec) > (int64_t)(framePeriodNsec / 2)) {
+                pacing->lateFrames++;
+            }
+        }
+    }
+
+    // Close the export first, everything from here on is diagnostics on stderr, never mixed into frames on stdout
+    if(isExporting) {
+        frameExportClose();
+        fprintf(stderr, "Exported %llu frames\n", (unsigned long long)frameExportCount());
+    }
+
+    if(timerPacing.frames > 0) {
+        fprintf(stderr, "Stopwatch/countdown: %llu frames at %d Hz, %llu late, %llu dropped\n", (unsigned long long)timerPacing.frames,
+                1000 / TIMER_FRAME_PERIOD_MS, (unsigned long long)timerPacing.lateFrames, (unsigned long long)timerPacing.droppedFrames);
     }
 
-    // Join the input thread
+    if(animationPacing.frames > 0) {
+        fprintf(stderr, "Digit animations: %llu frames at %d Hz, %llu late, %llu dropped\n", (unsigned long long)animationPacing.frames,
+                ANIM_FRAME_RATE, (unsigned long long)animationPacing.lateFrames, (unsigned long long)animationPacing.droppedFrames);
+    }
+
+    if(latchStats.latches > 0) {
+        fprintf(stderr, "Minute rollover: %llu frames latched, rollover to send latency mean %.1f us, p50 %llu us, p99 %llu us, max %.1f us\n",
+                (unsigned long long)latchStats.latches, (double)latchStats.totalNsec / latchStats.latches / 1000,
+                (unsigned long long)(getLatchPercentileNsec(0.5) / 1000), (unsigned long long)(getLatchPercentileNsec(0.99) / 1000),
+                (double)latchStats.maxNsec / 1000);
+    }
+    if(latchStats.abandoned > 0) {
+        fprintf(stderr, "Minute rollover: %llu latches given up after the wall clock was stepped\n", (unsigned long long)latchStats.abandoned);
+    }
+
+    if(options.controlPath != NULL) {
+        ctrl_stats_t controlStats = {0};
+        controlServerStop();
+        controlServerGetStats(&controlStats);
+        fprintf(stderr, "Control socket: %llu commands (%llu frames, %llu coalesced, %llu errors) in %llu wakeups\n",
+                (unsigned long long)controlStats.commands, (unsigned long long)controlStats.framesPushed,
+                (unsigned long long)controlStats.framesCoalesced, (unsigned long long)controlStats.errors,
+                (unsigned long long)controlStats.wakeups);
+    }
+
+    if(options.scanRowRateHz != 0) {
+        scanRefreshStop();
+        scanRefreshPrintStats();
+    }
+
+    if(options.wearPath != NULL) {
+        wear_stats_t wearStats = {0};
+        uint64_t onTicks[MATRIX_HEIGHT][MATRIX_WIDTH] = {0};
+        uint64_t totalTicks = 0;
+        uint64_t maxOnTicks = 0;
+
+        wearGetStats(&wearStats);
+        wearGetOnTime(onTicks, &totalTicks);
+        for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+            for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+                maxOnTicks = onTicks[i][j] > maxOnTicks ? onTicks[i][j] : maxOnTicks;
+            }
+        }
+        wearClose(getMonotonicNsec(TICK_SOURCE_PRECISE));
+        fprintf(stderr, "LED wear: %llu frames accounted, %llu flushes (mean %.1f us, max %.1f us). Most worn LED on %.1f%% of %.1f hours\n",
+                (unsigned long long)wearStats.frames, (unsigned long long)wearStats.flushes,
+                wearStats.flushes > 0 ? (double)wearStats.flushNsec / wearStats.flushes / 1000 : 0.0, (double)wearStats.maxFlushNsec / 1000,
+                totalTicks > 0 ? 100.0 * maxOnTicks / totalTicks : 0.0, (double)totalTicks * WEAR_TICK_MS / 3600000.0);
+    }
+
+    // Join the input thread. It may still be blocked waiting for a key if we did not quit from a key press.
+    pthread_cancel(getInputThread);
     pthread_join(getInputThread, NULL);
+
+    if(options.tracePath != NULL) {
+        trace_stats_t traceStats = {0};
+        traceSetEnabled(false);
+        traceGetStats(&traceStats);
+        if(traceWriteJson(options.tracePath) == LED_OK) {
+            fprintf(stderr, "Trace: %llu events from %u threads written to %s (%llu overwritten)\n",
+                    (unsigned long long)traceStats.eventsRecorded, traceStats.threads, options.tracePath,
+                    (unsigned long long)traceStats.eventsOverwritten);
+        }
+    }
     return 0;
 }
 
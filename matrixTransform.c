@@ -0,0 +1,248 @@
+/** ********************************************************************************
+*@file matrixTransform.c
+*
+*@date February 26th, 2026
+*
+*@author julio.liriano (julio.liriano@gmail.com)
+*
+*@brief
+********************************************************************************
+
+/* Includes ------------------------------------------------------------------*/
+#include "matrixTransform.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Imported variables --------------------------------------------------------*/
+
+/* Imported function prototypes ----------------------------------------------*/
+
+/* Private constants ---------------------------------------------------------*/
+// Transforms run on rows of up to 64 bits before scaling
+#define WORK_MAX_SIZE 64
+/* Private macros ------------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+
+/* Private variables ---------------------------------------------------------*/
+static output_transform_t outputTransform = {
+    .rotation = ROTATE_0,
+    .isMirrorH = false,
+    .isMirrorV = false,
+    .scale = 1
+};
+
+// Each byte of a row spread out to scale bits per pixel. Rebuilt when the scale changes.
+static uint64_t spreadTable[256];
+static uint8_t spreadTableScale = 0;
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Reverses the bit order of a 64 bit word.
+ * 
+ */
+static uint64_t reverseBits(uint64_t x);
+
+/**
+ * @brief Transposes an 8x8 bit matrix held in a word, one byte per row (bit 8 * row + col).
+ * 
+ */
+static uint64_t transpose8(uint64_t x);
+
+/**
+ * @brief Mirrors each row left/right.
+ * 
+ * @param rows - Packed rows, modified in place
+ * @param width - Row width in bits
+ * @param height - Number of rows
+ */
+static void mirrorRows(uint64_t rows[WORK_MAX_SIZE], uint16_t width, uint16_t height);
+
+/**
+ * @brief Mirrors the rows top/bottom.
+ * 
+ * @param rows - Packed rows, modified in place
+ * @param height - Number of rows
+ */
+static void flipRows(uint64_t rows[WORK_MAX_SIZE], uint16_t height);
+
+/**
+ * @brief Transposes a packed bit matrix in 8x8 blocks. Output has width rows of height bits.
+ * 
+ * @param in - Input rows
+ * @param width - Input width
+ * @param height - Input height
+ * @param out - Output rows
+ */
+static void transposeRows(const uint64_t in[WORK_MAX_SIZE], uint16_t width, uint16_t height, uint64_t out[WORK_MAX_SIZE]);
+
+/* Definitions ---------------------------------------------------------------*/
+static uint64_t reverseBits(uint64_t x)
+{
+    x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    x = ((x >> 8) & 0x00FF00FF00FF00FFULL) | ((x & 0x00FF00FF00FF00FFULL) << 8);
+    x = ((x >> 16) & 0x0000FFFF0000FFFFULL) | ((x & 0x0000FFFF0000FFFFULL) << 16);
+    return (x >> 32) | (x << 32);
+}
+
+static uint64_t transpose8(uint64_t x)
+{
+    // Swap 1x1 blocks within 2x2, then 2x2 within 4x4, then 4x4 within 8x8 (Hacker's Delight 7-3)
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x = x ^ t ^ (t << 28);
+    return x;
+}
+
+static void mirrorRows(uint64_t rows[WORK_MAX_SIZE], uint16_t width, uint16_t height)
+{
+    for(uint16_t i = 0; i < height; i++) {
+        rows[i] = reverseBits(rows[i]) >> (WORK_MAX_SIZE - width);
+    }
+}
+
+static void flipRows(uint64_t rows[WORK_MAX_SIZE], uint16_t height)
+{
+    for(uint16_t i = 0; i < height / 2; i++) {
+        uint64_t tmp = rows[i];
+        rows[i] = rows[height - 1 - i];
+        rows[height - 1 - i] = tmp;
+    }
+}
+
+static void transposeRows(const uint64_t in[WORK_MAX_SIZE], uint16_t width, uint16_t height, uint64_t out[WORK_MAX_SIZE])
+{
+    memset(out, 0, width * sizeof(uint64_t));
+
+    for(uint16_t rowBlock = 0; rowBlock < height; rowBlock += 8) {
+        for(uint16_t colBlock = 0; colBlock < width; colBlock += 8) {
+            uint64_t block = 0;
+
+            // Gather the 8x8 block, one byte per row
+            for(uint16_t r = 0; r < 8 && rowBlock + r < height; r++) {
+                block |= ((in[rowBlock + r] >> colBlock) & 0xFFULL) << (8 * r);
+            }
+            block = transpose8(block);
+
+            // Each byte is now a column of the block, i.e. a row of the output
+            for(uint16_t c = 0; c < 8 && colBlock + c < width; c++) {
+                out[colBlock + c] |= ((block >> (8 * c)) & 0xFFULL) << rowBlock;
+            }
+        }
+    }
+}
+
+led_matrix_err_t setOutputTransform(const output_transform_t *transform)
+{
+    if(transform == NULL || transform->rotation < 0 || transform->rotation >= NUM_ROTATIONS ||
+       transform->scale < 1 || transform->scale > TRANSFORM_MAX_SCALE) {
+        printf("Invalid argument: output transform\n");
+        return LED_ARG_ERROR;
+    }
+    memcpy(&outputTransform, transform, sizeof(output_transform_t));
+    return LED_OK;
+}
+
+void getOutputTransform(output_transform_t *transform)
+{
+    if(transform != NULL) {
+        memcpy(transform, &outputTransform, sizeof(output_transform_t));
+    }
+}
+
+void transformFrame(const matrix_row_t rows[MATRIX_HEIGHT], output_frame_t *out)
+{
+    uint64_t work[WORK_MAX_SIZE] = {0};
+    uint64_t transposed[WORK_MAX_SIZE] = {0};
+    uint64_t *src = work;
+    uint16_t width = MATRIX_WIDTH;
+    uint16_t height = MATRIX_HEIGHT;
+    uint8_t scale = outputTransform.scale;
+
+    for(uint16_t i = 0; i < MATRIX_HEIGHT; i++) {
+        work[i] = rows[i];
+    }
+
+    if(outputTransform.isMirrorH) {
+        mirrorRows(work, width, height);
+    }
+    if(outputTransform.isMirrorV) {
+        flipRows(work, height);
+    }
+
+    switch(outputTransform.rotation) {
+        case ROTATE_90:
+            // Clockwise: transpose, then mirror left/right
+            transposeRows(work, width, height, transposed);
+            src = transposed;
+            width = MATRIX_HEIGHT;
+            height = MATRIX_WIDTH;
+            mirrorRows(src, width, height);
+            break;
+        case ROTATE_180:
+            mirrorRows(work, width, height);
+            flipRows(work, height);
+            break;
+        case ROTATE_270:
+            // Counter clockwise: transpose, then mirror top/bottom
+            transposeRows(work, width, height, transposed);
+            src = transposed;
+            width = MATRIX_HEIGHT;
+            height = MATRIX_WIDTH;
+            flipRows(src, height);
+            break;
+        default:
+            break;
+    }
+
+    out->width = width * scale;
+    out->height = height * scale;
+
+    if(scale == 1) {
+        for(uint16_t i = 0; i < height; i++) {
+            memset(out->rows[i], 0, sizeof(out->rows[i]));
+            out->rows[i][0] = src[i];
+        }
+        return;
+    }
+
+    if(spreadTableScale != scale) {
+        // Spread each bit of a byte over scale bits
+        for(uint32_t b = 0; b < 256; b++) {
+            uint64_t spread = 0;
+            for(uint8_t j = 0; j < 8; j++) {
+                if(b & (1U << j)) {
+                    spread |= ((1ULL << scale) - 1) << (j * scale);
+                }
+            }
+            spreadTable[b] = spread;
+        }
+        spreadTableScale = scale;
+    }
+
+    for(uint16_t i = 0; i < height; i++) {
+        uint64_t *outRow = out->rows[i * scale];
+        memset(outRow, 0, sizeof(out->rows[0]));
+
+        // Scale up a byte at a time, each byte becomes 8 * scale bits
+        for(uint16_t byte = 0; byte * 8 < width; byte++) {
+            uint64_t spread = spreadTable[(src[i] >> (8 * byte)) & 0xFFULL];
+            uint32_t bit = (uint32_t)byte * 8 * scale;
+            outRow[bit / 64] |= spread << (bit % 64);
+            if((bit % 64) != 0 && (bit / 64) + 1 < OUTPUT_ROW_WORDS) {
+                outRow[bit / 64 + 1] |= spread >> (64 - (bit % 64));
+            }
+        }
+
+        // The other rows of the scaled row are copies
+        for(uint8_t k = 1; k < scale; k++) {
+            memcpy(out->rows[i * scale + k], outRow, sizeof(out->rows[0]));
+        }
+    }
+}
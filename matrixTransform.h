@@ -0,0 +1,89 @@
+/** ********************************************************************************
+*@file matrixTransform.h
+*@date February 26th, 2026
+*@author julio.liriano (julio.liriano@gmail.com)
+*@brief Output transform stage between the LED matrix frame and the panel. Rotates, 
+*       mirrors and scales up the frame for panels mounted upside down, behind glass 
+*       or on larger walls. Works on packed rows with bit-reversal and 8x8 bit-matrix 
+*       transpose kernels instead of remapping one pixel at a time.
+*
+********************************************************************************** */
+#ifndef __MATRIXTRANSFORM_H
+#define __MATRIXTRANSFORM_H
+/* Includes ------------------------------------------------------------------*/
+#include "ledMatrix.h"
+#include <stdint.h>
+#include <stdbool.h>
+/* Exported constants --------------------------------------------------------*/
+#define TRANSFORM_MAX_SCALE 8
+#define OUTPUT_MAX_SIZE ((MATRIX_WIDTH > MATRIX_HEIGHT ? MATRIX_WIDTH : MATRIX_HEIGHT) * TRANSFORM_MAX_SCALE)
+#define OUTPUT_ROW_WORDS ((OUTPUT_MAX_SIZE + 63) / 64)
+/* Exported macros -----------------------------------------------------------*/
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    ROTATE_0 = 0,
+    ROTATE_90,      // Clockwise
+    ROTATE_180,
+    ROTATE_270,
+    NUM_ROTATIONS // should always be last
+} rotation_t;
+
+// Mirroring is applied first, then rotation, then scaling.
+typedef struct {
+    rotation_t rotation;
+    bool isMirrorH;     // Flip left/right
+    bool isMirrorV;     // Flip top/bottom
+    uint8_t scale;      // Integer upscale (1 to TRANSFORM_MAX_SCALE)
+} output_transform_t;
+
+// Frame as sent to the panel. Packed rows, bit (x % 64) of word (x / 64) is column x.
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint64_t rows[OUTPUT_MAX_SIZE][OUTPUT_ROW_WORDS];
+} output_frame_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Sets the output transform. The default is no rotation, no mirroring and a scale of 1.
+ * 
+ * @param transform - New output transform.
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t setOutputTransform(const output_transform_t *transform);
+
+/**
+ * @brief Gets the current output transform.
+ * 
+ * @param transform - Output, current transform.
+ */
+void getOutputTransform(output_transform_t *transform);
+
+/**
+ * @brief Applies the output transform to a packed frame.
+ * 
+ * @param rows - Packed LED matrix frame.
+ * @param out - Output frame for the panel.
+ */
+void transformFrame(const matrix_row_t rows[MATRIX_HEIGHT], output_frame_t *out);
+
+/**
+ * @brief Returns whether a pixel of an output frame is lit.
+ * 
+ * @param frame - Output frame
+ * @param x - Column
+ * @param y - Row
+ * @return true - Pixel is lit
+ * @return false - Pixel is off
+ */
+static inline bool getOutputPixel(const output_frame_t *frame, uint16_t x, uint16_t y)
+{
+    return (frame->rows[y][x / 64] >> (x % 64)) & 1U;
+}
+#endif /* __MATRIXTRANSFORM_H */
+
+
+
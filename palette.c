@@ -0,0 +1,298 @@
+/** ********************************************************************************
+*@file palette.c
+*
+*@date March 12th, 2026
+*
+*@author julio.liriano (julio.liriano@gmail.com)
+*
+*@brief
+********************************************************************************
+
+/* Includes ------------------------------------------------------------------*/
+#include "palette.h"
+#include "compositor.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Imported variables --------------------------------------------------------*/
+
+/* Imported function prototypes ----------------------------------------------*/
+
+/* Private constants ---------------------------------------------------------*/
+#define LANE_ONES 0x0101010101010101ULL     // 1 in every byte of a word
+#define LANE_PIXELS 8                       // Pixels converted per word
+#define DEFAULT_COLOR ((rgb_color_t){.r = 0, .g = 200, .b = 0})
+/* Private macros ------------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    const char *name;
+    rgb_color_t colors[PALETTE_SIZE];
+    uint8_t numColors;                      // Entries past this repeat the first color
+    color_index_t layerColors[NUM_LAYERS];
+} theme_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const theme_t themes[] = {
+    {
+        .name = "classic",
+        .colors = {{0, 200, 0}},
+        .numColors = 1,
+        .layerColors = {0, 0, 0, 0}
+    },
+    {
+        .name = "contrast",
+        .colors = {{255, 255, 255}, {255, 0, 0}, {255, 160, 0}},
+        .numColors = 3,
+        .layerColors = {[LAYER_BACKGROUND] = 0, [LAYER_TIME] = 0, [LAYER_STATUS] = 1, [LAYER_OVERLAY] = 2}
+    },
+    {
+        .name = "night",
+        .colors = {{90, 0, 0}, {160, 0, 0}},
+        .numColors = 2,
+        .layerColors = {[LAYER_BACKGROUND] = 0, [LAYER_TIME] = 0, [LAYER_STATUS] = 1, [LAYER_OVERLAY] = 0}
+    },
+};
+
+static rgb_color_t palette[PALETTE_SIZE];
+static color_format_t outputFormat = COLOR_FORMAT_RGB565;
+static bool isPaletteLoaded = false;
+
+// Panel pixel for each conversion code: 0 is an unlit LED, 1 + index a lit one.
+// Rebuilt when the palette or the format changes.
+static uint8_t pixelTable[PALETTE_SIZE + 1][PALETTE_MAX_BYTES_PER_PIXEL];
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Fills the palette with the default color on first use.
+ *
+ */
+static void loadDefaultPalette(void);
+
+/**
+ * @brief Writes a color as a pixel in the current output format.
+ *
+ * @param color
+ * @param pixel - PALETTE_MAX_BYTES_PER_PIXEL bytes, unused bytes are zeroed
+ */
+static void encodePixel(rgb_color_t color, uint8_t *pixel);
+
+/**
+ * @brief Rebuilds the pixel table from the palette in the current output format.
+ *
+ */
+static void buildPixelTable(void);
+
+/**
+ * @brief Spreads the 8 bits of a byte over the 8 bytes of a word, bit k goes to bit 0 of byte k.
+ *
+ */
+static uint64_t spreadBits(uint8_t bits);
+
+/* Definitions ---------------------------------------------------------------*/
+static void loadDefaultPalette(void)
+{
+    if(isPaletteLoaded) {
+        return;
+    }
+    for(uint8_t i = 0; i < PALETTE_SIZE; i++) {
+        palette[i] = DEFAULT_COLOR;
+    }
+    isPaletteLoaded = true;
+    buildPixelTable();
+}
+
+static void encodePixel(rgb_color_t color, uint8_t *pixel)
+{
+    if(outputFormat == COLOR_FORMAT_RGB565) {
+        uint16_t rgb565 = (uint16_t)(((color.r >> 3) << 11) | ((color.g >> 2) << 5) | (color.b >> 3));
+        pixel[0] = (uint8_t)(rgb565 >> 8);
+        pixel[1] = (uint8_t)(rgb565 & 0xFF);
+        pixel[2] = 0;
+    } else {
+        pixel[0] = color.r;
+        pixel[1] = color.g;
+        pixel[2] = color.b;
+    }
+}
+
+static void buildPixelTable(void)
+{
+    memset(pixelTable[0], 0, sizeof(pixelTable[0]));
+    for(uint8_t i = 0; i < PALETTE_SIZE; i++) {
+        encodePixel(palette[i], pixelTable[i + 1]);
+    }
+}
+
+static uint64_t spreadBits(uint8_t bits)
+{
+    // Byte k of the product is a copy of bits, keep only bit k of it and carry it up to bit 7.
+    // Adding 0x7F never carries out of a byte, so each byte is done independently.
+    uint64_t lanes = ((uint64_t)bits * LANE_ONES) & 0x8040201008040201ULL;
+    return ((lanes + 0x7F7F7F7F7F7F7F7FULL) >> 7) & LANE_ONES;
+}
+
+led_matrix_err_t paletteSetColor(color_index_t index, rgb_color_t color)
+{
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(index >= PALETTE_SIZE) {
+            printf("Invalid argument: palette index=%u\n", index);
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        loadDefaultPalette();
+        palette[index] = color;
+        buildPixelTable();
+    } while(0);
+    return status;
+}
+
+rgb_color_t paletteGetColor(color_index_t index)
+{
+    loadDefaultPalette();
+    if(index >= PALETTE_SIZE) {
+        return (rgb_color_t){0};
+    }
+    return palette[index];
+}
+
+led_matrix_err_t paletteApplyTheme(const char *name)
+{
+    const theme_t *theme = NULL;
+    led_matrix_err_t status = LED_OK;
+
+    for(size_t t = 0; t < sizeof(themes) / sizeof(themes[0]) && name != NULL; t++) {
+        if(strcmp(name, themes[t].name) == 0) {
+            theme = &themes[t];
+        }
+    }
+    do {
+        if(theme == NULL) {
+            printf("Invalid argument: theme=%s\n", name != NULL ? name : "(null)");
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        for(uint8_t i = 0; i < PALETTE_SIZE; i++) {
+            palette[i] = theme->colors[i < theme->numColors ? i : 0];
+        }
+        isPaletteLoaded = true;
+        buildPixelTable();
+
+        for(uint8_t layer = 0; layer < NUM_LAYERS; layer++) {
+            layerSetColor((layer_id_t)layer, theme->layerColors[layer]);
+        }
+    } while(0);
+    return status;
+}
+
+led_matrix_err_t paletteSetOutputFormat(color_format_t format)
+{
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(format < 0 || format >= NUM_COLOR_FORMATS) {
+            printf("Invalid argument: color format=%d\n", format);
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        loadDefaultPalette();
+        outputFormat = format;
+        buildPixelTable();
+    } while(0);
+    return status;
+}
+
+color_format_t paletteGetOutputFormat(void)
+{
+    return outputFormat;
+}
+
+uint8_t paletteGetBytesPerPixel(color_format_t format)
+{
+    switch(format) {
+        case COLOR_FORMAT_RGB565:
+            return 2;
+        case COLOR_FORMAT_RGB888:
+            return 3;
+        default:
+            return 0;
+    }
+}
+
+size_t paletteConvertFrame(const output_frame_t *lit, const output_frame_t planes[COLOR_BITS], 
+                           const output_frame_t dimming[DIMMING_BITS], uint8_t *out)
+{
+    uint8_t bytesPerPixel = paletteGetBytesPerPixel(outputFormat);
+    uint8_t *pixel = out;
+    size_t size = 0;
+
+    do {
+        if(lit == NULL || planes == NULL || out == NULL) {
+            printf("Invalid argument: frame or buffer is NULL\n");
+            break;
+        }
+
+        loadDefaultPalette();
+        for(uint16_t y = 0; y < lit->height; y++) {
+            for(uint16_t x = 0; x < lit->width; x += LANE_PIXELS) {
+                uint16_t word = x / 64;
+                uint8_t shift = x % 64;
+                uint8_t count = (lit->width - x) < LANE_PIXELS ? (uint8_t)(lit->width - x) : LANE_PIXELS;
+                uint64_t litLanes = spreadBits((uint8_t)(lit->rows[y][word] >> shift));
+
+                // Index of each pixel in its own byte, then 1 + index for lit pixels and 0 for the rest.
+                // Indices are below 16, so the add never carries into the next pixel. Runs of unlit 
+                // pixels, most of a clock face, skip the planes.
+                uint64_t codes = 0;
+                uint64_t dims = 0;
+                if(litLanes != 0) {
+                    uint64_t index = 0;
+                    for(uint8_t b = 0; b < COLOR_BITS; b++) {
+                        index |= spreadBits((uint8_t)(planes[b].rows[y][word] >> shift)) << b;
+                    }
+                    codes = (index + LANE_ONES) & (litLanes * 0xFF);
+
+                    // Dimming of each pixel in its own byte, only kept for lit pixels
+                    for(uint8_t b = 0; b < DIMMING_BITS && dimming != NULL; b++) {
+                        dims |= spreadBits((uint8_t)(dimming[b].rows[y][word] >> shift)) << b;
+                    }
+                    dims &= litLanes * 0xFF;
+                }
+
+                if(dims != 0) {
+                    // Dimmed LEDs are scaled one by one, the rest still come from the table
+                    for(uint8_t k = 0; k < count; k++, pixel += bytesPerPixel, codes >>= 8, dims >>= 8) {
+                        uint8_t pixelBytes[PALETTE_MAX_BYTES_PER_PIXEL];
+                        uint16_t level = (uint16_t)(LED_BRIGHTNESS_MAX - (dims & 0xFF));
+                        if((dims & 0xFF) == 0) {
+                            memcpy(pixel, pixelTable[codes & 0xFF], bytesPerPixel);
+                            continue;
+                        }
+                        rgb_color_t color = palette[(codes & 0xFF) - 1];
+                        color.r = (uint8_t)(color.r * level / LED_BRIGHTNESS_MAX);
+                        color.g = (uint8_t)(color.g * level / LED_BRIGHTNESS_MAX);
+                        color.b = (uint8_t)(color.b * level / LED_BRIGHTNESS_MAX);
+                        encodePixel(color, pixelBytes);
+                        memcpy(pixel, pixelBytes, bytesPerPixel);
+                    }
+                } else if(bytesPerPixel == 2) {
+                    for(uint8_t k = 0; k < count; k++, pixel += 2, codes >>= 8) {
+                        memcpy(pixel, pixelTable[codes & 0xFF], 2);
+                    }
+                } else {
+                    for(uint8_t k = 0; k < count; k++, pixel += 3, codes >>= 8) {
+                        memcpy(pixel, pixelTable[codes & 0xFF], 3);
+                    }
+                }
+            }
+        }
+        size = (size_t)(pixel - out);
+    } while(0);
+    return size;
+}
@@ -0,0 +1,104 @@
+/** ********************************************************************************
+*@file palette.h
+*@date March 12th, 2026
+*@author julio.liriano (julio.liriano@gmail.com)
+*@brief Palette for RGB panels. Each lit LED carries a COLOR_BITS palette index, kept
+*       as bit planes next to the monochrome frame, and themes pick the palette and the
+*       color of each layer. Indices are turned into RGB565 or RGB888 in a single pass
+*       at send time, eight pixels per 64 bit word.
+*
+********************************************************************************** */
+#ifndef __PALETTE_H
+#define __PALETTE_H
+/* Includes ------------------------------------------------------------------*/
+#include "ledMatrix.h"
+#include "matrixTransform.h"
+#include <stdint.h>
+#include <stddef.h>
+/* Exported constants --------------------------------------------------------*/
+#define PALETTE_MAX_BYTES_PER_PIXEL 3
+#define PANEL_BUFFER_SIZE (OUTPUT_MAX_SIZE * OUTPUT_MAX_SIZE * PALETTE_MAX_BYTES_PER_PIXEL)
+#define DIMMING_BITS 8      // Bit planes of the dimming of each LED (LED_BRIGHTNESS_MAX minus its drive level)
+/* Exported macros -----------------------------------------------------------*/
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} rgb_color_t;
+
+typedef enum {
+    COLOR_FORMAT_RGB565 = 0,    // 2 bytes per pixel, high byte first
+    COLOR_FORMAT_RGB888,        // 3 bytes per pixel, R G B
+    NUM_COLOR_FORMATS // should always be last
+} color_format_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Sets a palette entry. The default palette is green for every entry.
+ *
+ * @param index - 0 to PALETTE_SIZE - 1
+ * @param color
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t paletteSetColor(color_index_t index, rgb_color_t color);
+
+/**
+ * @brief Gets a palette entry. Out of range indices read as black.
+ *
+ * @param index
+ * @return rgb_color_t
+ */
+rgb_color_t paletteGetColor(color_index_t index);
+
+/**
+ * @brief Applies a named theme: loads its palette and sets the color of each layer.
+ *        Themes are "classic" (all green), "contrast" (white digits, red alarm dot,
+ *        amber overlays) and "night" (dim red).
+ *
+ * @param name - Theme name
+ * @return led_matrix_err_t - LED_ARG_ERROR for an unknown theme.
+ */
+led_matrix_err_t paletteApplyTheme(const char *name);
+
+/**
+ * @brief Sets the color format of the panel. The default is RGB565.
+ *
+ * @param format
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t paletteSetOutputFormat(color_format_t format);
+
+/**
+ * @brief Gets the color format of the panel.
+ *
+ * @return color_format_t
+ */
+color_format_t paletteGetOutputFormat(void);
+
+/**
+ * @brief Returns the bytes per pixel of a color format.
+ *
+ * @param format
+ * @return uint8_t - 0 for an invalid format.
+ */
+uint8_t paletteGetBytesPerPixel(color_format_t format);
+
+/**
+ * @brief Converts a transformed frame and its transformed palette index planes to the panel
+ *        color format, row by row, left to right. Unlit pixels are black. Lit pixels with a 
+ *        dimming are scaled to their drive level (color * level / LED_BRIGHTNESS_MAX).
+ *
+ * @param lit - Output frame, which pixels are lit.
+ * @param planes - COLOR_BITS output frames (same transform as lit), bit b of each pixel's index.
+ * @param dimming - DIMMING_BITS output frames (same transform as lit), bit b of each pixel's 
+ *                  dimming, or NULL for full brightness.
+ * @param out - Pixel buffer, lit->width * lit->height * bytes per pixel (at most PANEL_BUFFER_SIZE).
+ * @return size_t - Number of bytes written.
+ */
+size_t paletteConvertFrame(const output_frame_t *lit, const output_frame_t planes[COLOR_BITS], 
+                           const output_frame_t dimming[DIMMING_BITS], uint8_t *out);
+#endif /* __PALETTE_H */
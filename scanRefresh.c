@@ -0,0 +1,333 @@
+/** ********************************************************************************
+*@file scanRefresh.c
+*
+*@date February 12th, 2026
+*
+*@author julio.liriano (julio.liriano@gmail.com)
+*
+*@brief
+********************************************************************************
+
+/* Includes ------------------------------------------------------------------*/
+#define _GNU_SOURCE // For pthread_setaffinity_np()
+#include "scanRefresh.h"
+#include "timeFuncs.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+
+/* Imported variables --------------------------------------------------------*/
+
+/* Imported function prototypes ----------------------------------------------*/
+
+/* Private constants ---------------------------------------------------------*/
+#define JITTER_BUCKETS 4096 // 1 usec buckets, anything later lands in the last bucket
+#define NSEC_PER_USEC 1000ULL
+/* Private macros ------------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    pthread_t thread;
+    atomic_bool isRunning;
+    const scan_backend_t *backend;
+    scan_config_t config;
+    scan_stats_t stats;
+    uint32_t jitterHistogram[JITTER_BUCKETS];
+} scan_refresh_t;
+
+// Frames published by the render thread. frameSeq is odd while a frame is being written, and 
+// frameSeq / 2 is the number of frames published, the newest one in frames[(frameSeq / 2) & 1]. 
+// The other buffer is the one being written, so the refresh thread only has to retry if the 
+// render thread got two frames ahead while it was copying.
+typedef struct {
+    atomic_uint frameSeq;
+    _Atomic matrix_row_t frames[2][MATRIX_HEIGHT];
+} scan_frame_t;
+
+/* Private variables ---------------------------------------------------------*/
+static scan_refresh_t scanner = {0};
+static scan_frame_t published = {0};
+
+static const scan_config_t defaultConfig = {
+    .rowRateHz = SCAN_DEFAULT_ROW_RATE_HZ,
+    .cpu = SCAN_NO_CPU,
+    .priority = SCAN_DEFAULT_PRIORITY,
+    .isLockMemory = true
+};
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Null backend row write. Does nothing.
+ * 
+ */
+static led_matrix_err_t nullWriteRow(uint8_t row, const uint8_t pixels[MATRIX_WIDTH]);
+
+/**
+ * @brief Refresh thread. Sleeps to the absolute deadline of each row, then scans it out.
+ * 
+ * @param ptr - Unused
+ * @return void* 
+ */
+static void *scan_thread(void *ptr);
+
+/**
+ * @brief Returns the lateness (nsec) at or below which the given fraction of row wake ups were.
+ * 
+ * @param fraction - Fraction of samples (0.0 to 1.0)
+ * @return uint64_t - Lateness in nsec (bucket resolution)
+ */
+static uint64_t jitterPercentile(double fraction);
+
+/**
+ * @brief Copies the newest complete published frame and unpacks it into pixels.
+ * 
+ * @param frame - Output pixels
+ */
+static void latchFrame(uint8_t frame[MATRIX_HEIGHT][MATRIX_WIDTH]);
+
+/* Definitions ---------------------------------------------------------------*/
+const scan_backend_t scanNullBackend = {
+    .name = "null",
+    .writeRow = nullWriteRow
+};
+
+static led_matrix_err_t nullWriteRow(uint8_t row, const uint8_t pixels[MATRIX_WIDTH])
+{
+    (void)row;
+    (void)pixels;
+    return LED_OK;
+}
+
+static void *scan_thread(void *ptr)
+{
+    uint8_t frame[MATRIX_HEIGHT][MATRIX_WIDTH] = {0};
+    uint64_t periodNsec = NSEC_PER_SEC / scanner.config.rowRateHz;
+    uint64_t deadline = 0;
+    uint8_t row = 0;
+    (void)ptr;
+
+#if defined(__linux__)
+    if(scanner.config.cpu != SCAN_NO_CPU) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(scanner.config.cpu, &cpuSet);
+        scanner.stats.isPinned = (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0);
+    }
+#endif
+
+    deadline = getMonotonicNsec(TICK_SOURCE_PRECISE) + periodNsec;
+    while(scanner.isRunning) {
+        sleepUntilMonotonicNsec(deadline);
+        uint64_t now = getMonotonicNsec(TICK_SOURCE_PRECISE);
+        uint64_t lateNsec = now > deadline ? now - deadline : 0;
+        uint64_t bucket = lateNsec / NSEC_PER_USEC;
+
+        scanner.jitterHistogram[bucket < JITTER_BUCKETS ? bucket : JITTER_BUCKETS - 1]++;
+        if(lateNsec > scanner.stats.jitterMaxNsec) {
+            scanner.stats.jitterMaxNsec = lateNsec;
+        }
+        if(lateNsec >= periodNsec) {
+            scanner.stats.deadlineMisses++;
+            scanner.stats.rowMisses[row]++;
+        }
+
+        // Latch a new frame at the start of each scan so rows of one scan never mix frames
+        if(row == 0) {
+            latchFrame(frame);
+            scanner.stats.framesScanned++;
+        }
+        scanner.backend->writeRow(row, frame[row]);
+        scanner.stats.rowsScanned++;
+        row = (row + 1) % MATRIX_HEIGHT;
+        deadline += periodNsec;
+
+        // If we stalled for more than a whole row, those rows were never shown on time. 
+        // Count each as missed against its own row and pick the schedule back up from now, 
+        // at the row due now, instead of bursting to catch up.
+        while(deadline + periodNsec < now) {
+            scanner.stats.deadlineMisses++;
+            scanner.stats.rowMisses[row]++;
+            row = (row + 1) % MATRIX_HEIGHT;
+            deadline += periodNsec;
+        }
+    }
+    return NULL;
+}
+
+static void latchFrame(uint8_t frame[MATRIX_HEIGHT][MATRIX_WIDTH])
+{
+    matrix_row_t rows[MATRIX_HEIGHT];
+    unsigned int seq = 0;
+    unsigned int seqAfter = 0;
+
+    do {
+        seq = atomic_load_explicit(&published.frameSeq, memory_order_acquire);
+        for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+            rows[i] = atomic_load_explicit(&published.frames[(seq / 2) & 1][i], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        seqAfter = atomic_load_explicit(&published.frameSeq, memory_order_relaxed);
+    } while(seqAfter - (seq & ~1U) > 2); // Started writing into the buffer we were copying
+
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+            frame[i][j] = (rows[i] >> j) & 1U;
+        }
+    }
+}
+
+static uint64_t jitterPercentile(double fraction)
+{
+    uint64_t total = 0;
+    uint64_t count = 0;
+
+    for(uint32_t i = 0; i < JITTER_BUCKETS; i++) {
+        total += scanner.jitterHistogram[i];
+    }
+    if(total == 0) {
+        return 0;
+    }
+
+    uint64_t target = (uint64_t)(fraction * (double)total);
+    for(uint32_t i = 0; i < JITTER_BUCKETS; i++) {
+        count += scanner.jitterHistogram[i];
+        if(count > target) {
+            return (uint64_t)i * NSEC_PER_USEC;
+        }
+    }
+    return scanner.stats.jitterMaxNsec;
+}
+
+led_matrix_err_t scanRefreshStart(const scan_backend_t *backend, const scan_config_t *config)
+{
+    led_matrix_err_t status = LED_OK;
+    pthread_attr_t attr;
+    struct sched_param param = {0};
+    int threadStatus = 0;
+
+    do
+    {
+        if (config == NULL)
+        {
+            config = &defaultConfig;
+        }
+
+        //Check for valid arguments
+        if (backend == NULL || backend->writeRow == NULL || 
+            config->rowRateHz == 0 || config->rowRateHz > NSEC_PER_SEC)
+        {
+            printf("Invalid argument: scan refresh backend or row rate\n");
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        if (scanner.isRunning)
+        {
+            status = LED_BUSY;
+            break;
+        }
+
+        memset(&scanner.stats, 0, sizeof(scanner.stats));
+        memset(scanner.jitterHistogram, 0, sizeof(scanner.jitterHistogram));
+        scanner.backend = backend;
+        scanner.config = *config;
+        scanner.isRunning = true;
+
+        // Lock pages before the thread starts so the scan never waits on a page fault
+        if (config->isLockMemory)
+        {
+            scanner.stats.isMemoryLocked = (mlockall(MCL_CURRENT | MCL_FUTURE) == 0);
+        }
+
+        threadStatus = -1;
+        if (config->priority > 0)
+        {
+            pthread_attr_init(&attr);
+            pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+            pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+            param.sched_priority = config->priority;
+            pthread_attr_setschedparam(&attr, &param);
+            threadStatus = pthread_create(&scanner.thread, &attr, scan_thread, NULL);
+            pthread_attr_destroy(&attr);
+            scanner.stats.isRealtime = (threadStatus == 0);
+        }
+
+        // Not allowed to use SCHED_FIFO (no CAP_SYS_NICE / rtprio limit), run as a normal thread
+        if (config->priority <= 0 || threadStatus == EPERM)
+        {
+            threadStatus = pthread_create(&scanner.thread, NULL, scan_thread, NULL);
+        }
+
+        if (threadStatus != 0)
+        {
+            printf("Error creating scan refresh thread: %d\n", threadStatus);
+            scanner.isRunning = false;
+            status = LED_BUSY;
+            break;
+        }
+    } while (0);
+    return status;
+}
+
+led_matrix_err_t scanRefreshStop(void)
+{
+    if(!scanner.isRunning) {
+        return LED_ARG_ERROR;
+    }
+    scanner.isRunning = false;
+    pthread_join(scanner.thread, NULL);
+    if(scanner.stats.isMemoryLocked) {
+        munlockall();
+    }
+    return LED_OK;
+}
+
+void scanRefreshPublishFrame(const matrix_row_t rows[MATRIX_HEIGHT])
+{
+    unsigned int seq = atomic_load_explicit(&published.frameSeq, memory_order_relaxed);
+    uint8_t buffer = ((seq / 2) + 1) & 1;
+
+    // Odd while writing, so a reader that sees it knows the newest complete frame is still the other buffer
+    atomic_store_explicit(&published.frameSeq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        atomic_store_explicit(&published.frames[buffer][i], rows[i], memory_order_relaxed);
+    }
+    atomic_store_explicit(&published.frameSeq, seq + 2, memory_order_release);
+}
+
+void scanRefreshGetStats(scan_stats_t *stats)
+{
+    if(stats == NULL) {
+        return;
+    }
+    scanner.stats.jitterP50Nsec = jitterPercentile(0.50);
+    scanner.stats.jitterP99Nsec = jitterPercentile(0.99);
+    scanner.stats.jitterP999Nsec = jitterPercentile(0.999);
+    memcpy(stats, &scanner.stats, sizeof(scan_stats_t));
+}
+
+void scanRefreshPrintStats(void)
+{
+    scan_stats_t stats = {0};
+    scanRefreshGetStats(&stats);
+
+    fprintf(stderr, "Scan refresh (%s backend, %u rows/s): %s, %s, %s\n", scanner.backend != NULL ? scanner.backend->name : "no",
+            scanner.config.rowRateHz,
+            stats.isRealtime ? "SCHED_FIFO" : "normal scheduling",
+            stats.isPinned ? "pinned" : "not pinned",
+            stats.isMemoryLocked ? "memory locked" : "memory not locked");
+    fprintf(stderr, "  rows %llu, frames %llu, deadline misses %llu\n", (unsigned long long)stats.rowsScanned,
+            (unsigned long long)stats.framesScanned, (unsigned long long)stats.deadlineMisses);
+    fprintf(stderr, "  misses per row:");
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        fprintf(stderr, " %llu", (unsigned long long)stats.rowMisses[i]);
+    }
+    fprintf(stderr, "\n  jitter p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n", 
+            stats.jitterP50Nsec / 1000.0, stats.jitterP99Nsec / 1000.0, 
+            stats.jitterP999Nsec / 1000.0, stats.jitterMaxNsec / 1000.0);
+}
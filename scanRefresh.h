@@ -0,0 +1,104 @@
+/** ********************************************************************************
+*@file scanRefresh.h
+*@date February 12th, 2026
+*@author julio.liriano (julio.liriano@gmail.com)
+*@brief Real-time row scan refresh for multiplexed LED panels. A dedicated thread 
+*       scans the published frame into an output backend one row at a time at a fixed 
+*       rate and measures how well it keeps up.
+*
+********************************************************************************** */
+#ifndef __SCANREFRESH_H
+#define __SCANREFRESH_H
+/* Includes ------------------------------------------------------------------*/
+#include "ledMatrix.h"
+#include <stdint.h>
+#include <stdbool.h>
+/* Exported constants --------------------------------------------------------*/
+#define SCAN_DEFAULT_ROW_RATE_HZ 7000   // 1 kHz full frame refresh on a 7 row panel
+#define SCAN_DEFAULT_PRIORITY 80        // SCHED_FIFO priority (1-99)
+#define SCAN_NO_CPU -1                  // Don't pin the refresh thread to a core
+/* Exported macros -----------------------------------------------------------*/
+
+/* Exported types ------------------------------------------------------------*/
+// Output backend the rows are scanned into (e.g. a GPIO/SPI panel driver). 
+typedef struct {
+    const char *name;
+    /**
+     * @brief Drives a single row of the panel. Called from the refresh thread, must not block.
+     * 
+     * @param row - Row index (0 to MATRIX_HEIGHT - 1)
+     * @param pixels - Pixel values of the row
+     * @return led_matrix_err_t - Status of the operation.
+     */
+    led_matrix_err_t (*writeRow)(uint8_t row, const uint8_t pixels[MATRIX_WIDTH]);
+} scan_backend_t;
+
+typedef struct {
+    uint32_t rowRateHz;     // Rows scanned per second. Frame rate is rowRateHz / MATRIX_HEIGHT.
+    int cpu;                // Core to pin the refresh thread to, or SCAN_NO_CPU
+    int priority;           // SCHED_FIFO priority, 0 runs the thread with the normal scheduler
+    bool isLockMemory;      // mlock all memory so the refresh thread never page faults
+} scan_config_t;
+
+typedef struct {
+    uint64_t rowsScanned;
+    uint64_t framesScanned;
+    uint64_t deadlineMisses;                // Rows started more than one row period late (or skipped)
+    uint64_t rowMisses[MATRIX_HEIGHT];      // Deadline misses per row
+    uint64_t jitterP50Nsec;                 // Wake up lateness percentiles
+    uint64_t jitterP99Nsec;
+    uint64_t jitterP999Nsec;
+    uint64_t jitterMaxNsec;
+    bool isRealtime;                        // Running with SCHED_FIFO
+    bool isPinned;                          // Pinned to the requested core
+    bool isMemoryLocked;                    // mlockall() succeeded
+} scan_stats_t;
+
+/* Exported variables --------------------------------------------------------*/
+// Backend that drops every row. Used for testing the refresh timing on any Linux box.
+extern const scan_backend_t scanNullBackend;
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Starts the refresh thread. Real-time scheduling, pinning and memory locking 
+ *        are best effort: if not permitted the thread still runs and the stats say so.
+ * 
+ * @param backend - Output backend to scan rows into.
+ * @param config - Refresh configuration. NULL uses the defaults.
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t scanRefreshStart(const scan_backend_t *backend, const scan_config_t *config);
+
+/**
+ * @brief Stops the refresh thread and waits for it to exit.
+ * 
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t scanRefreshStop(void);
+
+/**
+ * @brief Publishes the frame to scan out. Call from the one thread that renders the frames. 
+ *        The refresh thread latches the newest complete frame at the start of each scan, 
+ *        so the rows of one scan always come from the same frame.
+ * 
+ * @param rows - Packed frame
+ */
+void scanRefreshPublishFrame(const matrix_row_t rows[MATRIX_HEIGHT]);
+
+/**
+ * @brief Gets the refresh statistics. Jitter percentiles are computed from a histogram 
+ *        with 1 usec buckets. Call after scanRefreshStop() for a consistent snapshot.
+ * 
+ * @param stats - Output statistics.
+ */
+void scanRefreshGetStats(scan_stats_t *stats);
+
+/**
+ * @brief Prints the refresh statistics to stderr, stdout may be carrying exported frames.
+ * 
+ */
+void scanRefreshPrintStats(void);
+#endif /* __SCANREFRESH_H */
+
+
+
@@ -11,18 +11,33 @@
 /* Includes ------------------------------------------------------------------*/
 #include "timeFuncs.h"
 #include <stdio.h>
+#include <errno.h>
 /* Imported variables --------------------------------------------------------*/
 
 /* Imported function prototypes ----------------------------------------------*/
 
 /* Private constants ---------------------------------------------------------*/
+// Not every platform has a coarse monotonic clock (e.g. macOS). Fall back to the precise one.
+#ifdef CLOCK_MONOTONIC_COARSE
+    #define COARSE_CLOCK_ID CLOCK_MONOTONIC_COARSE
+#else
+    #define COARSE_CLOCK_ID CLOCK_MONOTONIC
+#endif
 
 /* Private macros ------------------------------------------------------------*/
 
 /* Private types -------------------------------------------------------------*/
 
 /* Private variables ---------------------------------------------------------*/
-static uint64_t initTickCount = 0;
+static uint64_t initTickNsec = 0; // Monotonic time (nsec) when initTick() was called
+static tick_source_t tickSource = TICK_SOURCE_PRECISE;
+static uint32_t timeScale = 1; // Time acceleration factor
+static uint64_t initWallNsec = 0; // Wall clock time (nsec since epoch) when initTick() was called, base for accelerated time
+
+static const clockid_t tickClockIds[NUM_TICK_SOURCES] = {
+    [TICK_SOURCE_PRECISE] = CLOCK_MONOTONIC,
+    [TICK_SOURCE_COARSE] = COARSE_CLOCK_ID
+};
 /* Private functions ---------------------------------------------------------*/
 
 /* Definitions ---------------------------------------------------------------*/
@@ -38,13 +53,69 @@ uint64_t getTimeInMsec(void) {
     return absMsec;
 }
 
+uint64_t getMonotonicNsec(tick_source_t source) {
+    struct timespec ts = {0};
+
+    if(source < 0 || source >= NUM_TICK_SOURCES) {
+        source = TICK_SOURCE_PRECISE;
+    }
+    clock_gettime(tickClockIds[source], &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+void sleepUntilMonotonicNsec(uint64_t deadlineNsec) {
+    struct timespec ts = {
+        .tv_sec = (time_t)(deadlineNsec / NSEC_PER_SEC),
+        .tv_nsec = (long)(deadlineNsec % NSEC_PER_SEC)
+    };
+
+    // Restart if interrupted by a signal, the deadline stays the same
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+uint64_t getWallNsec(void) {
+    struct timespec ts = {0};
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
 void initTick(void) {
-    initTickCount = getTimeInMsec();
+    initTickNsec = getMonotonicNsec(TICK_SOURCE_PRECISE);
+    initWallNsec = getWallNsec();
+}
+
+void setTimeScale(uint32_t scale) {
+    if(scale == 0) {
+        printf("Invalid time scale: %u\n", scale);
+        return;
+    }
+    timeScale = scale;
+}
+
+void setTickSource(tick_source_t source) {
+    if(source < 0 || source >= NUM_TICK_SOURCES) {
+        printf("Invalid tick source: %d\n", source);
+        return;
+    }
+    tickSource = source;
+}
+
+uint64_t getTickNsec(void) {
+    return (getMonotonicNsec(TICK_SOURCE_PRECISE) - initTickNsec) * timeScale;
 }
 
 uint64_t getTick(void) {
-    uint64_t currentMsec = getTimeInMsec();
-    return currentMsec - initTickCount;
+    // A coarse tick gets too coarse once scaled up, so accelerated time always uses the precise source
+    uint64_t currentNsec = getMonotonicNsec(timeScale == 1 ? tickSource : TICK_SOURCE_PRECISE);
+
+    // The coarse clock lags the precise one by up to one jiffy, so it can read
+    // slightly before the initTick() timestamp right after start up.
+    if(currentNsec < initTickNsec) {
+        return 0;
+    }
+    return (currentNsec - initTickNsec) * timeScale / NSEC_PER_MSEC;
 }
 
 void delayMsec(uint64_t msec) {
@@ -54,10 +125,55 @@ void delayMsec(uint64_t msec) {
     }
 }
 
+void sleepUntilTickNsec(uint64_t tickNsec) {
+    sleepUntilMonotonicNsec(initTickNsec + tickNsec / timeScale);
+}
+
+uint64_t getEpochNsec(void) {
+    if(timeScale == 1) {
+        return getWallNsec();
+    }
+    // Accelerated time runs from the wall clock time at start up
+    return initWallNsec + getTickNsec();
+}
+
+time_t getEpochTime(void) {
+    // Not time(), it may read a coarse clock that lags a second rollover by a few msec
+    return (time_t)(getEpochNsec() / NSEC_PER_SEC);
+}
+
+bool sleepUntilEpochNsec(uint64_t epochNsec, uint64_t limitTickNsec) {
+    if(timeScale != 1) {
+        if(epochNsec <= initWallNsec) {
+            return true;
+        }
+        if(epochNsec - initWallNsec > limitTickNsec) {
+            return false;
+        }
+        sleepUntilTickNsec(epochNsec - initWallNsec);
+        return true;
+    }
+
+    // Sleep the remaining interval on the monotonic clock, then check the wall clock again. A step 
+    // of the wall clock meanwhile can neither keep us asleep past the limit nor wake us early.
+    for(;;) {
+        uint64_t wallNsec = getWallNsec();
+        uint64_t tickNsec = getTickNsec();
+        if(wallNsec >= epochNsec) {
+            return true;
+        }
+        if(tickNsec + (epochNsec - wallNsec) > limitTickNsec) {
+            return false;
+        }
+        sleepUntilTickNsec(tickNsec + (epochNsec - wallNsec));
+    }
+}
+
 void getTime(struct tm *timeInfo) {
-    time_t rawTime;
-    time(&rawTime);
+    getTimeAt(getEpochTime(), timeInfo);
+}
 
+void getTimeAt(time_t rawTime, struct tm *timeInfo) {
     // Null check for timeInfo pointer
     if(timeInfo == NULL) {
         printf("Error: timeInfo pointer is NULL\n");
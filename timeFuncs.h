@@ -10,11 +10,19 @@
 /* Includes ------------------------------------------------------------------*/
 #include <time.h>
 #include <stdint.h>
+#include <stdbool.h>
 /* Exported constants --------------------------------------------------------*/
-
+#define NSEC_PER_MSEC 1000000ULL
+#define NSEC_PER_SEC  1000000000ULL
 /* Exported macros -----------------------------------------------------------*/
 
 /* Exported types ------------------------------------------------------------*/
+// Clock sources the tick counter can be read from. 
+typedef enum {
+    TICK_SOURCE_PRECISE = 0,    // CLOCK_MONOTONIC, nanosecond resolution
+    TICK_SOURCE_COARSE,         // CLOCK_MONOTONIC_COARSE, ~1-4 msec resolution but much cheaper to read
+    NUM_TICK_SOURCES // should always be last
+} tick_source_t;
 
 /* Exported variables --------------------------------------------------------*/
 
@@ -26,12 +34,59 @@
  */
 uint64_t getTimeInMsec(void); 
 
+/**
+ * @brief Reads the given monotonic clock source directly. Not affected by wall-clock (NTP) steps.
+ * 
+ * @param source - Clock source to read.
+ * @return uint64_t - Nanoseconds since an unspecified starting point (usually boot).
+ */
+uint64_t getMonotonicNsec(tick_source_t source);
+
+/**
+ * @brief Sleeps until the precise monotonic clock reaches an absolute time. Sleeping to an absolute 
+ *        deadline (rather than for a duration) keeps periodic loops from drifting.
+ * 
+ * @param deadlineNsec - Absolute time on the getMonotonicNsec(TICK_SOURCE_PRECISE) timeline.
+ */
+void sleepUntilMonotonicNsec(uint64_t deadlineNsec);
+
+/**
+ * @brief Reads the wall clock (CLOCK_REALTIME) with nanosecond resolution. Not accelerated.
+ * 
+ * @return uint64_t - Nanoseconds since the epoch.
+ */
+uint64_t getWallNsec(void);
+
 /**
  * @brief Initializes the tick counter. Should be called once at the start of the program.
  * 
  */
 void initTick(void);
 
+/**
+ * @brief Runs the clock faster than real time, e.g. to export hours of display in seconds. 
+ *        Ticks, delays and getTime() all advance scale times faster than real time. 
+ *        Must be called before initTick(). A scale of 1 (default) is real time.
+ * 
+ * @param scale - Time acceleration factor (>= 1).
+ */
+void setTimeScale(uint32_t scale);
+
+/**
+ * @brief Selects the clock source used by getTick(). The precise source is the default. 
+ *        The coarse source is meant for high-frequency callers that only need millisecond resolution.
+ * 
+ * @param source - Clock source to use.
+ */
+void setTickSource(tick_source_t source);
+
+/**
+ * @brief Returns number of nanosecond ticks since the program started. Always uses the precise source.
+ * 
+ * @return uint64_t - Number of nanoseconds since initTick() was called.
+ */
+uint64_t getTickNsec(void);
+
 /**
  * @brief Returns number of 1 msec ticks since the program started.
  * 
@@ -46,12 +101,55 @@ uint64_t getTick(void);
  */
 void delayMsec(uint64_t msec);
 
+/**
+ * @brief Sleeps until the tick counter reaches the given value in nanoseconds. Sleeps to an absolute 
+ *        deadline, so periodic loops using deadline += period do not drift. Honors the time scale.
+ * 
+ * @param tickNsec - Absolute tick (nsec since initTick(), as returned by getTickNsec()) to wait for.
+ */
+void sleepUntilTickNsec(uint64_t tickNsec);
+
+/**
+ * @brief Gets the current time in nanoseconds since the epoch (UTC). Accelerated when a time scale is set.
+ * 
+ * @return uint64_t - Current time.
+ */
+uint64_t getEpochNsec(void);
+
+/**
+ * @brief Gets the current time in seconds since the epoch (UTC). Accelerated when a time scale is set.
+ * 
+ * @return time_t - Current time.
+ */
+time_t getEpochTime(void);
+
+/**
+ * @brief Sleeps until the (possibly accelerated) time reaches an absolute time since the epoch, 
+ *        unless that is past a tick limit. When time is not accelerated it sleeps the remaining 
+ *        interval on the monotonic clock and checks the wall clock again, so the wait stays 
+ *        bounded if the wall clock is stepped meanwhile.
+ * 
+ * @param epochNsec - Time to wake up at, on the getEpochNsec() timeline.
+ * @param limitTickNsec - Give up if the wake up would be after this tick (getTickNsec() timeline).
+ * @return true - The time was reached.
+ * @return false - Gave up, the time is past the limit (e.g. the wall clock was stepped back).
+ */
+bool sleepUntilEpochNsec(uint64_t epochNsec, uint64_t limitTickNsec);
+
 /**
  * @brief Gets the current local time and fills the provided tm structure. The hour is converted to 12-hour format.
  * 
  * @param timeInfo - Pointer to a tm structure that will be filled with the current local time information.
  */
 void getTime(struct tm *timeInfo);
+
+/**
+ * @brief Converts a time since the epoch to local time, in the same 12-hour format as getTime().
+ * 
+ * @param rawTime - Time in seconds since the epoch.
+ * @param timeInfo - Pointer to a tm structure that will be filled with the local time information.
+ */
+void getTimeAt(time_t rawTime, struct tm *timeInfo);
 #endif /* __TIMEFUNCS_H */
 
 
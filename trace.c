@@ -0,0 +1,225 @@
+/** ********************************************************************************
+*@file trace.c
+*
+*@date March 2nd, 2026
+*
+*@author julio.liriano (julio.liriano@gmail.com)
+*
+*@brief
+********************************************************************************
+
+/* Includes ------------------------------------------------------------------*/
+#include "trace.h"
+#include "timeFuncs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+/* Imported variables --------------------------------------------------------*/
+
+/* Imported function prototypes ----------------------------------------------*/
+
+/* Private constants ---------------------------------------------------------*/
+#define TRACE_RING_MASK (TRACE_RING_EVENTS - 1)
+#define NSEC_PER_USEC 1000ULL
+/* Private macros ------------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    uint64_t timeNsec;
+    const char *name;
+    trace_phase_t phase;
+} trace_event_t;
+
+// Ring buffer owned by a single thread. Only the owner writes events and head, so
+// recording needs no lock. Readers use head to find out which slots are valid.
+typedef struct {
+    _Atomic uint64_t head;      // Number of events ever recorded, next slot is head & TRACE_RING_MASK
+    uint32_t tid;
+    char name[TRACE_NAME_SIZE];
+    trace_event_t events[TRACE_RING_EVENTS];
+} trace_buffer_t;
+
+/* Private variables ---------------------------------------------------------*/
+volatile bool traceIsEnabled = false;
+
+static trace_buffer_t *_Atomic traceBuffers[TRACE_MAX_THREADS];
+static _Atomic uint32_t traceThreadCount = 0;
+static _Atomic uint64_t traceOriginNsec = 0; // Timestamps in the JSON are relative to this
+
+// Buffer of the calling thread, allocated on its first event
+static _Thread_local trace_buffer_t *threadBuffer = NULL;
+static _Thread_local bool isThreadRejected = false;
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Gets (allocating on first use) the ring buffer of the calling thread.
+ *
+ * @return trace_buffer_t* - NULL if all buffers are in use or allocation failed.
+ */
+static trace_buffer_t *getThreadBuffer(void);
+
+/* Definitions ---------------------------------------------------------------*/
+static trace_buffer_t *getThreadBuffer(void)
+{
+    if(threadBuffer != NULL || isThreadRejected) {
+        return threadBuffer;
+    }
+
+    uint32_t index = atomic_fetch_add(&traceThreadCount, 1);
+    trace_buffer_t *buffer = NULL;
+    if(index < TRACE_MAX_THREADS) {
+        buffer = calloc(1, sizeof(trace_buffer_t));
+    }
+    if(buffer == NULL) {
+        // Slot stays reserved (and empty) so the other threads' indices don't change
+        isThreadRejected = true;
+        return NULL;
+    }
+
+    buffer->tid = index + 1;
+    snprintf(buffer->name, sizeof(buffer->name), "thread %u", index + 1);
+    atomic_store_explicit(&traceBuffers[index], buffer, memory_order_release);
+    threadBuffer = buffer;
+    return buffer;
+}
+
+void traceSetEnabled(bool isEnabled)
+{
+    uint64_t expected = 0;
+    if(isEnabled) {
+        atomic_compare_exchange_strong(&traceOriginNsec, &expected, getMonotonicNsec(TICK_SOURCE_PRECISE));
+    }
+    traceIsEnabled = isEnabled;
+}
+
+void traceSetThreadName(const char *name)
+{
+    trace_buffer_t *buffer = getThreadBuffer();
+
+    if(buffer != NULL && name != NULL) {
+        snprintf(buffer->name, sizeof(buffer->name), "%s", name);
+    }
+}
+
+void traceRecord(const char *name, trace_phase_t phase)
+{
+    trace_buffer_t *buffer = getThreadBuffer();
+    if(buffer == NULL) {
+        return;
+    }
+
+    // Single writer: fill the slot, then publish it by moving head
+    uint64_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    trace_event_t *event = &buffer->events[head & TRACE_RING_MASK];
+    event->timeNsec = getMonotonicNsec(TICK_SOURCE_PRECISE);
+    event->name = name;
+    event->phase = phase;
+    atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+}
+
+led_matrix_err_t traceWriteJson(const char *path)
+{
+    static trace_event_t snapshot[TRACE_RING_EVENTS];
+    led_matrix_err_t status = LED_OK;
+    uint32_t threads = atomic_load(&traceThreadCount);
+    uint64_t originNsec = atomic_load(&traceOriginNsec);
+    bool isFirst = true;
+    FILE *file = NULL;
+
+    do {
+        if(path == NULL) {
+            printf("Invalid trace file path\n");
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        file = fopen(path, "w");
+        if(file == NULL) {
+            printf("Could not open trace file: %s\n", path);
+            status = LED_IO_ERROR;
+            break;
+        }
+
+        fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        if(threads > TRACE_MAX_THREADS) {
+            threads = TRACE_MAX_THREADS;
+        }
+        for(uint32_t t = 0; t < threads; t++) {
+            trace_buffer_t *buffer = atomic_load_explicit(&traceBuffers[t], memory_order_acquire);
+            if(buffer == NULL) {
+                continue;
+            }
+
+            // Copy the valid part of the ring, then drop whatever the owner overwrote meanwhile
+            uint64_t end = atomic_load_explicit(&buffer->head, memory_order_acquire);
+            uint64_t start = end > TRACE_RING_EVENTS ? end - TRACE_RING_EVENTS : 0;
+            for(uint64_t i = start; i < end; i++) {
+                snapshot[i - start] = buffer->events[i & TRACE_RING_MASK];
+            }
+            atomic_thread_fence(memory_order_acquire);
+            uint64_t headAfter = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+            uint64_t firstValid = headAfter > TRACE_RING_EVENTS ? headAfter - TRACE_RING_EVENTS : 0;
+            if(firstValid < start) {
+                firstValid = start;
+            }
+
+            fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    isFirst ? "" : ",\n", buffer->tid, buffer->name);
+            isFirst = false;
+
+            for(uint64_t i = firstValid; i < end; i++) {
+                const trace_event_t *event = &snapshot[i - start];
+                uint64_t timeNsec = event->timeNsec > originNsec ? event->timeNsec - originNsec : 0;
+                fprintf(file, ",\n{\"ph\":\"%c\",\"name\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%llu.%03llu%s}",
+                        (char)event->phase, event->name, buffer->tid,
+                        (unsigned long long)(timeNsec / NSEC_PER_USEC), (unsigned long long)(timeNsec % NSEC_PER_USEC),
+                        event->phase == TRACE_PHASE_INSTANT ? ",\"s\":\"t\"" : "");
+            }
+        }
+        fprintf(file, "\n]}\n");
+
+        if(fclose(file) != 0) {
+            printf("Error writing trace file: %s\n", path);
+            status = LED_IO_ERROR;
+        }
+    } while(0);
+    return status;
+}
+
+void traceReset(void)
+{
+    uint32_t threads = atomic_load(&traceThreadCount);
+
+    for(uint32_t t = 0; t < threads && t < TRACE_MAX_THREADS; t++) {
+        trace_buffer_t *buffer = atomic_load(&traceBuffers[t]);
+        if(buffer != NULL) {
+            atomic_store(&buffer->head, 0);
+        }
+    }
+}
+
+void traceGetStats(trace_stats_t *stats)
+{
+    uint32_t threads = atomic_load(&traceThreadCount);
+
+    do {
+        if(stats == NULL) {
+            printf("Invalid trace stats pointer\n");
+            break;
+        }
+
+        memset(stats, 0, sizeof(*stats));
+        for(uint32_t t = 0; t < threads && t < TRACE_MAX_THREADS; t++) {
+            trace_buffer_t *buffer = atomic_load(&traceBuffers[t]);
+            if(buffer == NULL) {
+                continue;
+            }
+            uint64_t head = atomic_load(&buffer->head);
+            stats->threads++;
+            stats->eventsRecorded += head;
+            stats->eventsOverwritten += head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+        }
+    } while(0);
+}
@@ -0,0 +1,91 @@
+/** ********************************************************************************
+*@file trace.h
+*@date March 2nd, 2026
+*@author julio.liriano (julio.liriano@gmail.com)
+*@brief Low overhead event tracer. Each thread records begin/end and instant events
+*       into its own lock-free ring buffer. The buffers can be dumped as Chrome trace
+*       JSON (chrome://tracing or ui.perfetto.dev) for offline analysis.
+*
+********************************************************************************** */
+#ifndef __TRACE_H
+#define __TRACE_H
+/* Includes ------------------------------------------------------------------*/
+#include "ledMatrix.h"
+#include <stdint.h>
+#include <stdbool.h>
+/* Exported constants --------------------------------------------------------*/
+#define TRACE_MAX_THREADS 16        // Threads that can record events, others are ignored
+#define TRACE_RING_EVENTS 16384     // Events kept per thread (power of 2), oldest are overwritten
+#define TRACE_NAME_SIZE 16          // Thread name length including the terminator
+/* Exported macros -----------------------------------------------------------*/
+// Event names must be string literals (or otherwise live until the trace is written),
+// only the pointer is recorded. When tracing is off each macro is a single load and branch.
+#define TRACE_BEGIN(name)   do { if(__builtin_expect(traceIsEnabled, 0)) { traceRecord((name), TRACE_PHASE_BEGIN); } } while(0)
+#define TRACE_END(name)     do { if(__builtin_expect(traceIsEnabled, 0)) { traceRecord((name), TRACE_PHASE_END); } } while(0)
+#define TRACE_INSTANT(name) do { if(__builtin_expect(traceIsEnabled, 0)) { traceRecord((name), TRACE_PHASE_INSTANT); } } while(0)
+
+/* Exported types ------------------------------------------------------------*/
+// Values are the Chrome trace "ph" characters
+typedef enum {
+    TRACE_PHASE_BEGIN = 'B',
+    TRACE_PHASE_END = 'E',
+    TRACE_PHASE_INSTANT = 'i'
+} trace_phase_t;
+
+typedef struct {
+    uint32_t threads;           // Threads that recorded at least one event
+    uint64_t eventsRecorded;    // Events recorded since the last traceReset()
+    uint64_t eventsOverwritten; // Oldest events lost because a ring buffer wrapped
+} trace_stats_t;
+
+/* Exported variables --------------------------------------------------------*/
+// Checked by the TRACE_ macros. Use traceSetEnabled() to change it.
+extern volatile bool traceIsEnabled;
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Turns tracing on or off. Can be called at any time from any thread.
+ *
+ * @param isEnabled
+ */
+void traceSetEnabled(bool isEnabled);
+
+/**
+ * @brief Names the calling thread in the trace (e.g. "main", "input").
+ *
+ * @param name - Thread name, truncated to TRACE_NAME_SIZE - 1 characters.
+ */
+void traceSetThreadName(const char *name);
+
+/**
+ * @brief Records an event on the calling thread's ring buffer, timestamped with the
+ *        monotonic clock. Use the TRACE_ macros instead so nothing is done when tracing is off.
+ *
+ * @param name - Event name (string literal).
+ * @param phase - Begin, end or instant.
+ */
+void traceRecord(const char *name, trace_phase_t phase);
+
+/**
+ * @brief Writes the events currently held in the ring buffers as Chrome trace JSON.
+ *        Threads can keep recording while it runs, events overwritten during the dump
+ *        are left out.
+ *
+ * @param path - File to write.
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t traceWriteJson(const char *path);
+
+/**
+ * @brief Discards all recorded events. Must not be called while other threads are recording.
+ *
+ */
+void traceReset(void);
+
+/**
+ * @brief Gets the tracer statistics.
+ *
+ * @param stats - Filled with the current statistics.
+ */
+void traceGetStats(trace_stats_t *stats);
+#endif /* __TRACE_H */
@@ -11,10 +11,25 @@
 /* Includes ------------------------------------------------------------------*/
 #include "ledMatrix.h"
 #include "timeFuncs.h"
+#include "scanRefresh.h"
+#include "compositor.h"
+#include "controlServer.h"
+#include "matrixTransform.h"
+#include "trace.h"
+#include "worldClock.h"
+#include "animator.h"
+#include "palette.h"
+#include "ledWear.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 /* Imported variables --------------------------------------------------------*/
 
@@ -25,6 +40,40 @@
 /* Private macros ------------------------------------------------------------*/
 #define MAX_CHAR_TEST_CASES 6
 #define NUM_TEST_CASES 2
+
+// Exhaustive sweep of every display the clock can show. 
+// Hours are 0-12 since getTime() only folds hours above 12.
+#define SWEEP_NUM_HOURS 13
+#define SWEEP_NUM_MINUTES 60
+#define SWEEP_NUM_TIME_CASES (SWEEP_NUM_HOURS * SWEEP_NUM_MINUTES * 2) // x alarm set/clear
+#define SWEEP_NUM_DIGIT_CASES 11 // buttonCnt runs 0 to 10
+#define SWEEP_NUM_TIMER_CASES (60 * 100 + 100 * 60) // Stopwatch/countdown SS.cc and MM:SS
+#define SWEEP_FIRST_TIMER_CASE (SWEEP_NUM_TIME_CASES + 2 + SWEEP_NUM_DIGIT_CASES) // After the alarm, dash and digit screens
+#define SWEEP_NUM_LABEL_CASES 26 // Zone labels, every letter at every digit position
+#define SWEEP_FIRST_LABEL_CASE (SWEEP_FIRST_TIMER_CASE + SWEEP_NUM_TIMER_CASES)
+#define SWEEP_NUM_CASES (SWEEP_FIRST_LABEL_CASE + SWEEP_NUM_LABEL_CASES)
+
+#define SCAN_TEST_DURATION_MS 200
+#define SCAN_TEST_STALL_SCANS 100   // Scans before the stalling backend stalls
+#define SCAN_TEST_STALL_ROWS 5      // Row periods it stalls for
+
+#define CTRL_TEST_CLIENTS 16
+#define CTRL_TEST_ROUNDS 250 // Each round is 4 commands
+#define CTRL_TEST_QUERIES 200 // Pipelined queries, more replies than fit in the server's reply buffer
+
+#define WORLD_TEST_ZONES "America/New_York=NYC,Europe/London,Europe/Paris,Europe/Berlin,Australia/Lord_Howe," \
+                         "Asia/Kolkata=IND,Pacific/Chatham,America/St_Johns,Asia/Kathmandu,Africa/Casablanca,UTC"
+#define WORLD_TEST_STEP_SEC 7919 // Prime step so samples land at every time of day
+#define WORLD_TEST_REFRESH_YEARS 20 // The tables are rebuilt this far ahead, past the transitions listed in the zone files
+
+#define TRACE_TEST_THREADS 4
+#define TRACE_TEST_PAIRS 10000 // Begin/end pairs per thread, wraps the ring buffers
+#define TRACE_TEST_PATH "/tmp/matrixclock_trace_test.json"
+
+#define WEAR_TEST_PATH "/tmp/matrixclock_wear_test.bin"
+#define WEAR_TEST_FRAMES 20000
+#define WEAR_TEST_TICK_NSEC (WEAR_TICK_MS * NSEC_PER_MSEC)
+#define WEAR_TEST_CLOSE_TICKS 7         // The frame shown when the file is reopened stays on this long before the close
 /* Private types -------------------------------------------------------------*/
 typedef struct {
     character_t character;
@@ -38,6 +87,14 @@ typedef struct {
     uint8_t const (*expectedMatrix)[MATRIX_HEIGHT][MATRIX_WIDTH];
 } test_case_t;
 
+// Result of building a sweep case. 
+typedef struct {
+    char name[32];
+    char_test_case_t ops[MAX_CHAR_TEST_CASES];
+    size_t numOps;
+    bool isTimeLayer;   // Drawn like the clock (time and status layers), otherwise on the overlay
+} sweep_case_t;
+
 /* Private variables ---------------------------------------------------------*/
 const uint8_t ledMatrixExpected[NUM_TEST_CASES][MATRIX_HEIGHT][MATRIX_WIDTH] = {
 
@@ -89,13 +146,1589 @@ test_case_t testCases[NUM_TEST_CASES] = {
     
 };
 
+// Reference glyphs for the golden frame sweep. These are written out independently of the 
+// sprite tables in ledMatrix.c so a mistake in either one shows up as a mismatch.
+static const char *const referenceGlyphs[NUM_CHARACTERS][SPRITE_HEIGHT] = {
+    [ZERO_CHAR]  = {"###", "#.#", "#.#", "#.#", "###"},
+    [ONE_CHAR]   = {".#.", "##.", ".#.", ".#.", "###"},
+    [TWO_CHAR]   = {"###", "..#", "###", "#..", "###"},
+    [THREE_CHAR] = {"###", "..#", "###", "..#", "###"},
+    [FOUR_CHAR]  = {"#.#", "#.#", "###", "..#", "..#"},
+    [FIVE_CHAR]  = {"###", "#..", "###", "..#", "###"},
+    [SIX_CHAR]   = {"###", "#..", "###", "#.#", "###"},
+    [SEVEN_CHAR] = {"###", "..#", ".#.", "#..", "#.."},
+    [EIGHT_CHAR] = {"###", "#.#", "###", "#.#", "###"},
+    [NINE_CHAR]  = {"###", "#.#", "###", "..#", "###"},
+    [COLON_CHAR] = {"...", ".#.", "...", ".#.", "..."},
+    [DASH_CHAR]  = {"...", "...", "###", "...", "..."},
+    [DOT_CHAR]   = {"...", "...", "...", "...", ".#."},
+    [A_CHAR]     = {".#.", "#.#", "###", "#.#", "#.#"},
+    [B_CHAR]     = {"##.", "#.#", "##.", "#.#", "##."},
+    [C_CHAR]     = {"###", "#..", "#..", "#..", "###"},
+    [D_CHAR]     = {"##.", "#.#", "#.#", "#.#", "##."},
+    [E_CHAR]     = {"###", "#..", "##.", "#..", "###"},
+    [F_CHAR]     = {"###", "#..", "##.", "#..", "#.."},
+    [G_CHAR]     = {"###", "#..", "#.#", "#.#", "###"},
+    [H_CHAR]     = {"#.#", "#.#", "###", "#.#", "#.#"},
+    [I_CHAR]     = {"###", ".#.", ".#.", ".#.", "###"},
+    [J_CHAR]     = {"..#", "..#", "..#", "#.#", "###"},
+    [K_CHAR]     = {"#.#", "#.#", "##.", "#.#", "#.#"},
+    [L_CHAR]     = {"#..", "#..", "#..", "#..", "###"},
+    [M_CHAR]     = {"#.#", "###", "###", "#.#", "#.#"},
+    [N_CHAR]     = {"##.", "#.#", "#.#", "#.#", "#.#"},
+    [O_CHAR]     = {".#.", "#.#", "#.#", "#.#", ".#."},
+    [P_CHAR]     = {"###", "#.#", "###", "#..", "#.."},
+    [Q_CHAR]     = {"###", "#.#", "#.#", "###", "..#"},
+    [R_CHAR]     = {"##.", "#.#", "##.", "#.#", "#.#"},
+    [S_CHAR]     = {".##", "#..", ".#.", "..#", "##."},
+    [T_CHAR]     = {"###", ".#.", ".#.", ".#.", ".#."},
+    [U_CHAR]     = {"#.#", "#.#", "#.#", "#.#", "###"},
+    [V_CHAR]     = {"#.#", "#.#", "#.#", "#.#", ".#."},
+    [W_CHAR]     = {"#.#", "#.#", "###", "###", "#.#"},
+    [X_CHAR]     = {"#.#", "#.#", ".#.", "#.#", "#.#"},
+    [Y_CHAR]     = {"#.#", "#.#", ".#.", ".#.", ".#."},
+    [Z_CHAR]     = {"###", "..#", ".#.", "#..", "###"},
+};
+
+// Top left corner (row, col) of each position on the reference display
+static const uint8_t referenceOrigins[NUM_POSITIONS][2] = {
+    [POS1] = {1, 1},
+    [POS2] = {1, 5},
+    [COLON] = {1, 8},
+    [POS3] = {1, 11},
+    [POS4] = {1, 15},
+    [ALARM_DOT] = {0, 18}
+};
+
+static uint64_t scanTestRowWrites[MATRIX_HEIGHT] = {0};
+static matrix_row_t scanTestScanRow = 0;   // Row 0 of the scan being written, every row of a published test frame is the same
+static uint64_t scanTestTornRows = 0;
+static int16_t scanTestRowsAfterStall[2] = {-1, -1};  // Rows written right after the stalling backend stalled
+static bool isScanTestStalled = false;
+
+// What the control socket test handlers were called with
+static struct {
+    uint32_t alarmCalls;
+    uint32_t modeCalls;
+    uint32_t frameCalls;
+    uint8_t lastMode;
+    matrix_row_t lastFrame[MATRIX_HEIGHT];
+} ctrlTest;
+
 /* Private functions ---------------------------------------------------------*/
 
+/**
+ * @brief Checks the compositor blend modes, visibility, z-order and that unchanged layers 
+ *        are not blended again.
+ * 
+ * @return uint32_t - Number of failed checks
+ */
+static uint32_t runCompositorTest(void);
+
+/**
+ * @brief Checks every output transform (rotations x mirrors x scales) against a per-pixel 
+ *        reference remap.
+ * 
+ * @return uint32_t - Number of failed checks
+ */
+static uint32_t runTransformTest(void);
+
+/**
+ * @brief Checks the palette index each blend mode leaves on the composited frame, and the 
+ *        RGB565/RGB888 conversion of random frames under random transforms against a per-pixel 
+ *        palette lookup.
+ * 
+ * @return uint32_t - Number of failed checks
+ */
+static uint32_t runPaletteTest(void);
+
+/**
+ * @brief Checks the palette index of every pixel of the LED matrix. Pixels of the POS4 cell 
+ *        should have pos4Color, the alarm dot 2, the other lit pixels digitColor and unlit pixels 0.
+ * 
+ * @return uint32_t - Number of failed checks
+ */
+static uint32_t checkFrameColors(const char *name, color_index_t digitColor, color_index_t pos4Color);
+
+/**
+ * @brief Checks the on-time of random frames shown for random times (including reopening the 
+ *        wear file) against a per-LED count, the layout offset, and each leveling policy.
+ * 
+ * @return uint32_t - Number of failed checks
+ */
+static uint32_t runWearTest(void);
+
+/**
+ * @brief Compares the world clock with localtime_r() in every loaded zone over a time range.
+ * 
+ * @param start - Start of the range
+ * @param end - End of the range
+ * @param checked - Incremented for each time compared
+ * @return uint32_t - Number of failures
+ */
+static uint32_t checkWorldClockTimes(time_t start, time_t end, uint64_t *checked);
+
+/**
+ * @brief Checks the world clock tables against localtime_r() with TZ set, over the whole 
+ *        horizon and around every transition, plus labels and table sharing.
+ * 
+ * @return uint32_t - Number of failed checks
+ */
+static uint32_t runWorldClockTest(void);
+
+/**
+ * @brief Checks every frame of each transition for every digit pair against the reference glyphs, 
+ *        and the timing of a transition started through animatorSetCharacter().
+ * 
+ * @return uint32_t - Number of failed checks
+ */
+static uint32_t runAnimatorTest(void);
+
+/**
+ * @brief Thread recording TRACE_TEST_PAIRS begin/end pairs.
+ * 
+ */
+static void *traceTestThread(void *ptr);
+
+/**
+ * @brief Records events from several threads while dumping the trace, then checks the 
+ *        counts, pairing and ordering of the events in the written JSON.
+ * 
+ * @return uint32_t - Number of failed checks
+ */
+static uint32_t runTraceTest(void);
+
+/**
+ * @brief Control socket test handlers. Record what they were called with.
+ * 
+ */
+static led_matrix_err_t ctrlTestSetAlarm(bool isSet, uint8_t hour, uint8_t minute);
+static led_matrix_err_t ctrlTestSetMode(uint8_t mode);
+static void ctrlTestGetState(ctrl_state_t *state);
+static led_matrix_err_t ctrlTestPushFrame(const matrix_row_t rows[MATRIX_HEIGHT]);
+
+/**
+ * @brief Appends a control message to a buffer.
+ * 
+ * @return size_t - New buffer length
+ */
+static size_t appendControlMessage(uint8_t *buf, size_t len, uint8_t opcode, const void *payload, uint16_t length);
+
+/**
+ * @brief Connects many clients to the control socket, sends each a batch of commands 
+ *        and a state query, and checks the handlers, replies and stats.
+ * 
+ * @return uint32_t - Number of failed checks
+ */
+static uint32_t runControlServerTest(void);
+
+/**
+ * @brief Test backend for the scan refresh, counts row writes.
+ * 
+ */
+static led_matrix_err_t countingWriteRow(uint8_t row, const uint8_t pixels[MATRIX_WIDTH]);
+
+/**
+ * @brief Runs the scan refresh thread against a counting backend and checks that every row 
+ *        was scanned and the stats are consistent. Timing is only reported, not checked, 
+ *        since it depends on the machine.
+ * 
+ * @return uint32_t - Number of failed checks
+ */
+static uint32_t runScanRefreshTest(void);
+
+/**
+ * @brief Builds the sequence of characters the clock writes for one sweep case. Mirrors
+ *        setTimeDisplay(), setStatusDisplay(), setAlarmDisplay(), setDigitDisplay(), 
+ *        setTimerDisplay() and setWorldClockDisplay() in main.c.
+ * 
+ * @param index - Sweep case index (0 to SWEEP_NUM_CASES - 1)
+ * @param sweepCase - Output, the case name and character writes
+ */
+static void buildSweepCase(uint32_t index, sweep_case_t *sweepCase);
+
+/**
+ * @brief Independent reference renderer. Draws the character writes using the reference glyphs.
+ * 
+ * @param sweepCase - Case to render
+ * @param matrixOut - Output frame
+ */
+static void renderReference(const sweep_case_t *sweepCase, uint8_t matrixOut[MATRIX_HEIGHT][MATRIX_WIDTH]);
+
+/**
+ * @brief Renders a sweep case the way main.c does: the time through the animator into the time 
+ *        layer with the alarm dot in the status layer, everything else on a blank overlay, then 
+ *        the layers are composited and the frame goes through the output transform.
+ * 
+ * @param sweepCase - Case to render
+ * @param matrixOut - Output frame, as sent to the panel
+ */
+static void renderComposited(const sweep_case_t *sweepCase, uint8_t matrixOut[MATRIX_HEIGHT][MATRIX_WIDTH]);
+
+/**
+ * @brief Prints a pixel diff between the expected and actual frame. 
+ *        '#' lit in both, '+' only lit in actual, '-' only lit in expected.
+ * 
+ * @param name - Case name
+ * @param expected - Expected (reference) frame
+ * @param actual - Frame from getMatrix() or renderComposited()
+ */
+static void printFrameDiff(const char *name, uint8_t expected[MATRIX_HEIGHT][MATRIX_WIDTH], uint8_t actual[MATRIX_HEIGHT][MATRIX_WIDTH]);
+
+/**
+ * @brief Checks every worker'th sweep case starting at the worker index, drawn directly into 
+ *        the LED matrix and through the compositor path main.c renders with.
+ * 
+ * @param worker - Index of this worker
+ * @param numWorkers - Total number of workers
+ * @return uint32_t - Number of failed cases
+ */
+static uint32_t runSweepSlice(uint32_t worker, uint32_t numWorkers);
+
+/**
+ * @brief Runs the golden frame sweep across all cores. The LED matrix is a single global frame, 
+ *        so each worker is a forked process with its own copy.
+ * 
+ * @return uint32_t - Number of failed cases
+ */
+static uint32_t runGoldenFrameSweep(void);
 
 /* Definitions ---------------------------------------------------------------*/
+static void buildSweepCase(uint32_t index, sweep_case_t *sweepCase)
+{
+    size_t n = 0;
+
+    if(index < SWEEP_NUM_TIME_CASES) {
+        // Time display, including the alarm dot
+        uint8_t hour = (uint8_t)(index / (SWEEP_NUM_MINUTES * 2));
+        uint8_t minute = (uint8_t)((index / 2) % SWEEP_NUM_MINUTES);
+        bool isAlarmSet = (index % 2) != 0;
+
+        snprintf(sweepCase->name, sizeof(sweepCase->name), "time %02d:%02d alarm %s", hour, minute, isAlarmSet ? "set" : "clr");
+        sweepCase->ops[n++] = (char_test_case_t){hour / 10, POS1};
+        sweepCase->ops[n++] = (char_test_case_t){hour % 10, POS2};
+        sweepCase->ops[n++] = (char_test_case_t){COLON_CHAR, COLON};
+        sweepCase->ops[n++] = (char_test_case_t){minute / 10, POS3};
+        sweepCase->ops[n++] = (char_test_case_t){minute % 10, POS4};
+        sweepCase->ops[n++] = (char_test_case_t){isAlarmSet ? ALARM_CHAR_SET : ALARM_CHAR_CLR, ALARM_DOT};
+    } else if(index == SWEEP_NUM_TIME_CASES) {
+        // Alarm screen with the alarm set
+        snprintf(sweepCase->name, sizeof(sweepCase->name), "alarm screen");
+        sweepCase->ops[n++] = (char_test_case_t){FIVE_CHAR, POS2};
+        sweepCase->ops[n++] = (char_test_case_t){COLON_CHAR, COLON};
+        sweepCase->ops[n++] = (char_test_case_t){THREE_CHAR, POS3};
+        sweepCase->ops[n++] = (char_test_case_t){ZERO_CHAR, POS4};
+        sweepCase->ops[n++] = (char_test_case_t){ALARM_CHAR_SET, ALARM_DOT};
+    } else if(index == SWEEP_NUM_TIME_CASES + 1) {
+        // Alarm screen with no alarm set
+        snprintf(sweepCase->name, sizeof(sweepCase->name), "dash screen");
+        sweepCase->ops[n++] = (char_test_case_t){DASH_CHAR, POS1};
+        sweepCase->ops[n++] = (char_test_case_t){DASH_CHAR, POS2};
+        sweepCase->ops[n++] = (char_test_case_t){COLON_CHAR, COLON};
+        sweepCase->ops[n++] = (char_test_case_t){DASH_CHAR, POS3};
+        sweepCase->ops[n++] = (char_test_case_t){DASH_CHAR, POS4};
+        sweepCase->ops[n++] = (char_test_case_t){ALARM_CHAR_CLR, ALARM_DOT};
+    } else if(index < SWEEP_FIRST_TIMER_CASE) {
+        // Digit test mode
+        uint8_t buttonCnt = (uint8_t)(index - SWEEP_NUM_TIME_CASES - 2);
+        snprintf(sweepCase->name, sizeof(sweepCase->name), "digit mode %d", buttonCnt);
+        sweepCase->ops[n++] = (char_test_case_t){buttonCnt % 10, POS4};
+    } else if(index >= SWEEP_FIRST_LABEL_CASE) {
+        // World clock zone label, four consecutive letters
+        uint8_t letter = (uint8_t)(index - SWEEP_FIRST_LABEL_CASE);
+        snprintf(sweepCase->name, sizeof(sweepCase->name), "label %c%c%c%c", 'A' + letter, 'A' + (letter + 1) % 26, 
+                 'A' + (letter + 2) % 26, 'A' + (letter + 3) % 26);
+        sweepCase->ops[n++] = (char_test_case_t){A_CHAR + letter, POS1};
+        sweepCase->ops[n++] = (char_test_case_t){A_CHAR + (letter + 1) % 26, POS2};
+        sweepCase->ops[n++] = (char_test_case_t){A_CHAR + (letter + 2) % 26, POS3};
+        sweepCase->ops[n++] = (char_test_case_t){A_CHAR + (letter + 3) % 26, POS4};
+    } else {
+        // Stopwatch/countdown, SS.cc then MM:SS
+        uint32_t timerIndex = index - SWEEP_FIRST_TIMER_CASE;
+        bool isSeconds = timerIndex < 60 * 100;
+        uint8_t high = isSeconds ? (uint8_t)(timerIndex / 100) : (uint8_t)((timerIndex - 6000) / 60);
+        uint8_t low = isSeconds ? (uint8_t)(timerIndex % 100) : (uint8_t)((timerIndex - 6000) % 60);
+
+        snprintf(sweepCase->name, sizeof(sweepCase->name), "timer %02d%c%02d", high, isSeconds ? '.' : ':', low);
+        sweepCase->ops[n++] = (char_test_case_t){high / 10, POS1};
+        sweepCase->ops[n++] = (char_test_case_t){high % 10, POS2};
+        sweepCase->ops[n++] = (char_test_case_t){isSeconds ? DOT_CHAR : COLON_CHAR, COLON};
+        sweepCase->ops[n++] = (char_test_case_t){low / 10, POS3};
+        sweepCase->ops[n++] = (char_test_case_t){low % 10, POS4};
+    }
+    sweepCase->numOps = n;
+    sweepCase->isTimeLayer = index < SWEEP_NUM_TIME_CASES;
+}
+
+static void renderReference(const sweep_case_t *sweepCase, uint8_t matrixOut[MATRIX_HEIGHT][MATRIX_WIDTH])
+{
+    memset(matrixOut, 0, MATRIX_HEIGHT * MATRIX_WIDTH);
+
+    for(size_t k = 0; k < sweepCase->numOps; k++) {
+        character_t character = sweepCase->ops[k].character;
+        uint8_t row = referenceOrigins[sweepCase->ops[k].position][0];
+        uint8_t col = referenceOrigins[sweepCase->ops[k].position][1];
+
+        if(character == ALARM_CHAR_SET || character == ALARM_CHAR_CLR) {
+            matrixOut[row][col] = (character == ALARM_CHAR_SET);
+            continue;
+        }
+        for(uint8_t i = 0; i < SPRITE_HEIGHT; i++) {
+            for(uint8_t j = 0; j < SPRITE_WIDTH; j++) {
+                matrixOut[row + i][col + j] = (referenceGlyphs[character][i][j] == '#');
+            }
+        }
+    }
+}
+
+static void renderComposited(const sweep_case_t *sweepCase, uint8_t matrixOut[MATRIX_HEIGHT][MATRIX_WIDTH])
+{
+    static output_frame_t out;
+    matrix_row_t rows[MATRIX_HEIGHT] = {0};
+    matrix_row_t coverage[MATRIX_HEIGHT] = {0};
+
+    if(sweepCase->isTimeLayer) {
+        // setTimeDisplay() and setStatusDisplay(), with the clock showing
+        layerSetVisible(LAYER_OVERLAY, false);
+        layerClear(LAYER_STATUS);
+        for(size_t k = 0; k < sweepCase->numOps; k++) {
+            char_test_case_t op = sweepCase->ops[k];
+            if(op.position == ALARM_DOT) {
+                layerSetCharacter(LAYER_STATUS, op.character, op.position);
+            } else if(op.position != COLON) {
+                animatorSetCharacter(op.position, op.character, 0);
+            }
+        }
+        animatorRender(0, rows, coverage);
+        for(size_t k = 0; k < sweepCase->numOps; k++) {
+            if(sweepCase->ops[k].position == COLON) {
+                setCharacterInRows(sweepCase->ops[k].character, COLON, rows, coverage);
+            }
+        }
+        layerSetRows(LAYER_TIME, rows, coverage);
+    } else {
+        // The other screens draw on a blank overlay over the clock
+        layerFill(LAYER_OVERLAY, false);
+        layerSetVisible(LAYER_OVERLAY, true);
+        for(size_t k = 0; k < sweepCase->numOps; k++) {
+            layerSetCharacter(LAYER_OVERLAY, sweepCase->ops[k].character, sweepCase->ops[k].position);
+        }
+    }
+    compositeLayers();
+
+    // sendMatrix() sends the frame through the output transform
+    getMatrixRows(rows);
+    transformFrame(rows, &out);
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+            matrixOut[i][j] = getOutputPixel(&out, j, i);
+        }
+    }
+}
+
+static void printFrameDiff(const char *name, uint8_t expected[MATRIX_HEIGHT][MATRIX_WIDTH], uint8_t actual[MATRIX_HEIGHT][MATRIX_WIDTH])
+{
+    char line[MATRIX_WIDTH + 1] = {0};
+
+    printf("Sweep case \"%s\" failed. Pixel diff ('+' extra, '-' missing):\n", name);
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+            bool isExpected = expected[i][j] != 0;
+            bool isActual = actual[i][j] != 0;
+            line[j] = (isExpected && isActual) ? '#' : (isActual ? '+' : (isExpected ? '-' : '.'));
+        }
+        printf("  %s\n", line);
+    }
+    fflush(stdout);
+}
+
+static uint32_t runSweepSlice(uint32_t worker, uint32_t numWorkers)
+{
+    uint8_t expected[MATRIX_HEIGHT][MATRIX_WIDTH] = {0};
+    uint8_t actual[MATRIX_HEIGHT][MATRIX_WIDTH] = {0};
+    sweep_case_t sweepCase = {0};
+    char name[48];
+    uint32_t failures = 0;
+
+    // Same render setup as main.c with the default options
+    compositorInit();
+    animatorInit(TRANSITION_NONE);
+
+    for(uint32_t index = worker; index < SWEEP_NUM_CASES; index += numWorkers) {
+        bool isFailed = false;
+
+        buildSweepCase(index, &sweepCase);
+        renderReference(&sweepCase, expected);
+
+        clearMatrix();
+        for(size_t k = 0; k < sweepCase.numOps; k++) {
+            setCharacterAtPosition(sweepCase.ops[k].character, sweepCase.ops[k].position);
+        }
+        getMatrix(actual);
+        if(memcmp(expected, actual, sizeof(actual)) != 0) {
+            printFrameDiff(sweepCase.name, expected, actual);
+            isFailed = true;
+        }
+
+        renderComposited(&sweepCase, actual);
+        if(memcmp(expected, actual, sizeof(actual)) != 0) {
+            snprintf(name, sizeof(name), "%s, composited", sweepCase.name);
+            printFrameDiff(name, expected, actual);
+            isFailed = true;
+        }
+        failures += isFailed;
+    }
+    return failures;
+}
+
+static uint32_t runGoldenFrameSweep(void)
+{
+    long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t numWorkers = numCores > 0 ? (uint32_t)numCores : 1;
+    uint32_t failures = 0;
+    uint64_t start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+
+    fflush(stdout); // Don't let the workers inherit buffered output
+
+    for(uint32_t worker = 0; worker < numWorkers; worker++) {
+        pid_t pid = fork();
+        if(pid == 0) {
+            uint32_t workerFailures = runSweepSlice(worker, numWorkers);
+            _exit(workerFailures > 255 ? 255 : (int)workerFailures);
+        } else if(pid < 0) {
+            // Could not fork, check this slice here instead
+            failures += runSweepSlice(worker, numWorkers);
+        }
+    }
+
+    int waitStatus = 0;
+    while(wait(&waitStatus) > 0) {
+        if(WIFEXITED(waitStatus)) {
+            failures += (uint32_t)WEXITSTATUS(waitStatus);
+        } else {
+            failures++;
+        }
+    }
+
+    uint64_t elapsed = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+    printf("Golden frame sweep: %d cases on %u workers in %.2f ms, %u failed.\n", 
+           SWEEP_NUM_CASES, numWorkers, (double)elapsed / NSEC_PER_MSEC, failures);
+    return failures;
+}
+
+static uint32_t runCompositorTest(void)
+{
+    uint8_t expected[MATRIX_HEIGHT][MATRIX_WIDTH] = {0};
+    uint8_t actual[MATRIX_HEIGHT][MATRIX_WIDTH] = {0};
+    sweep_case_t sweepCase = {0};
+    uint32_t failures = 0;
+
+    // Time and alarm dot drawn in separate layers compose to the same frame as drawing them directly. 
+    // Sweep case 1 is 00:00 with the alarm set.
+    buildSweepCase(1, &sweepCase);
+    renderReference(&sweepCase, expected);
+    compositorInit();
+    for(size_t k = 0; k + 1 < sweepCase.numOps; k++) {
+        layerSetCharacter(LAYER_TIME, sweepCase.ops[k].character, sweepCase.ops[k].position);
+    }
+    layerSetCharacter(LAYER_STATUS, ALARM_CHAR_SET, ALARM_DOT);
+    compositeLayers();
+    getMatrix(actual);
+    if(memcmp(expected, actual, sizeof(actual)) != 0) {
+        printFrameDiff("compositor time + status", expected, actual);
+        failures++;
+    }
+
+    // Nothing changed, nothing is blended. Redrawing the same content is not a change either.
+    compositeLayers();
+    layerClear(LAYER_STATUS);
+    layerSetCharacter(LAYER_STATUS, ALARM_CHAR_SET, ALARM_DOT);
+    compositeLayers();
+    if(compositorGetBlendCount() != 0) {
+        printf("Compositor blended %d layers with no change.\n", compositorGetBlendCount());
+        failures++;
+    }
+
+    // Changing the top layer only blends the top layer
+    layerFill(LAYER_OVERLAY, false);
+    layerSetCharacter(LAYER_OVERLAY, SEVEN_CHAR, POS4);
+    compositeLayers();
+    if(compositorGetBlendCount() != 1) {
+        printf("Compositor blended %d layers for a top layer change.\n", compositorGetBlendCount());
+        failures++;
+    }
+    buildSweepCase(SWEEP_NUM_TIME_CASES + 2 + 7, &sweepCase); // digit mode 7
+    renderReference(&sweepCase, expected);
+    getMatrix(actual);
+    if(memcmp(expected, actual, sizeof(actual)) != 0) {
+        printFrameDiff("compositor replace overlay", expected, actual);
+        failures++;
+    }
+
+    // Hidden overlay shows the clock again
+    layerSetVisible(LAYER_OVERLAY, false);
+    compositeLayers();
+    buildSweepCase(1, &sweepCase);
+    renderReference(&sweepCase, expected);
+    getMatrix(actual);
+    if(memcmp(expected, actual, sizeof(actual)) != 0) {
+        printFrameDiff("compositor hidden overlay", expected, actual);
+        failures++;
+    }
+
+    // Mask the time with a full 8: only pixels lit in both stay lit (a 0 masked by an 8 is the 0)
+    layerSetVisible(LAYER_OVERLAY, true);
+    layerSetBlendMode(LAYER_OVERLAY, BLEND_MASK);
+    layerClear(LAYER_OVERLAY);
+    layerSetCharacter(LAYER_OVERLAY, EIGHT_CHAR, POS1);
+    layerSetCharacter(LAYER_OVERLAY, ONE_CHAR, POS2);
+    compositeLayers();
+    getMatrix(actual);
+    uint8_t maskFrame[MATRIX_HEIGHT][MATRIX_WIDTH] = {0};
+    sweep_case_t maskCase = {.numOps = 2, .ops = {{EIGHT_CHAR, POS1}, {ONE_CHAR, POS2}}};
+    renderReference(&maskCase, maskFrame);
+    buildSweepCase(1, &sweepCase);
+    renderReference(&sweepCase, expected);
+    for(uint8_t i = 1; i <= SPRITE_HEIGHT; i++) {
+        for(uint8_t j = 1; j <= 7; j++) { // POS1 and POS2 cells
+            if(j != 4) {
+                expected[i][j] &= maskFrame[i][j];
+            }
+        }
+    }
+    if(memcmp(expected, actual, sizeof(actual)) != 0) {
+        printFrameDiff("compositor mask", expected, actual);
+        failures++;
+    }
+
+    // Moving the overlay to the bottom puts the time layer back on top with OR
+    layerSetBlendMode(LAYER_OVERLAY, BLEND_REPLACE);
+    layerFill(LAYER_OVERLAY, true);
+    layerSetZOrder(LAYER_OVERLAY, 0);
+    compositeLayers();
+    getMatrix(actual);
+    memset(expected, 1, sizeof(expected));
+    if(memcmp(expected, actual, sizeof(actual)) != 0) {
+        printFrameDiff("compositor z-order", expected, actual);
+        failures++;
+    }
+
+    // Rendering ahead into a back buffer leaves the LED matrix alone until it is swapped in
+    matrix_row_t backBuffer[MATRIX_HEIGHT] = {0};
+    matrix_row_t frontRows[MATRIX_HEIGHT] = {0};
+    getMatrixRows(frontRows);
+    layerSetZOrder(LAYER_OVERLAY, NUM_LAYERS - 1);
+    layerSetVisible(LAYER_OVERLAY, false);
+    compositeLayersToRows(backBuffer, NULL);
+    getMatrix(actual);
+    if(memcmp(expected, actual, sizeof(actual)) != 0 || memcmp(backBuffer, frontRows, sizeof(backBuffer)) == 0) {
+        printf("Compositor back buffer render changed the LED matrix\n");
+        failures++;
+    }
+    setMatrixRows(backBuffer);
+    compositeLayers();
+    getMatrixRows(frontRows);
+    if(memcmp(backBuffer, frontRows, sizeof(backBuffer)) != 0) {
+        printf("Compositor back buffer swap failed\n");
+        failures++;
+    }
+
+    printf("Compositor test %s.\n", failures == 0 ? "passed" : "failed");
+    return failures;
+}
+
+static uint32_t runTransformTest(void)
+{
+    static output_frame_t out;
+    uint8_t frame[MATRIX_HEIGHT][MATRIX_WIDTH] = {0};
+    matrix_row_t rows[MATRIX_HEIGHT] = {0};
+    sweep_case_t sweepCase = {0};
+    uint32_t failures = 0;
+    uint32_t checked = 0;
+
+    // 12:34 with the alarm set, plus a few extra pixels so every corner is distinct
+    buildSweepCase((12 * SWEEP_NUM_MINUTES + 34) * 2 + 1, &sweepCase);
+    renderReference(&sweepCase, frame);
+    frame[MATRIX_HEIGHT - 1][0] = 1;
+    frame[MATRIX_HEIGHT - 1][1] = 1;
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+            rows[i] |= (matrix_row_t)frame[i][j] << j;
+        }
+    }
+
+    for(int rotation = 0; rotation < NUM_ROTATIONS; rotation++) {
+        for(uint8_t mirror = 0; mirror < 4; mirror++) {
+            for(uint8_t scale = 1; scale <= TRANSFORM_MAX_SCALE; scale++) {
+                output_transform_t transform = {(rotation_t)rotation, (mirror & 1) != 0, (mirror & 2) != 0, scale};
+                bool isRotated = (rotation == ROTATE_90 || rotation == ROTATE_270);
+                uint16_t width = isRotated ? MATRIX_HEIGHT : MATRIX_WIDTH;
+                uint16_t height = isRotated ? MATRIX_WIDTH : MATRIX_HEIGHT;
+                bool isMatch = true;
+
+                setOutputTransform(&transform);
+                transformFrame(rows, &out);
+                if(out.width != width * scale || out.height != height * scale) {
+                    isMatch = false;
+                }
+
+                // Work out where each source pixel lands and check the whole scaled block
+                for(uint16_t y = 0; y < MATRIX_HEIGHT && isMatch; y++) {
+                    for(uint16_t x = 0; x < MATRIX_WIDTH && isMatch; x++) {
+                        uint16_t mx = transform.isMirrorH ? MATRIX_WIDTH - 1 - x : x;
+                        uint16_t my = transform.isMirrorV ? MATRIX_HEIGHT - 1 - y : y;
+                        uint16_t ox = mx, oy = my;
+                        if(rotation == ROTATE_90) {
+                            ox = MATRIX_HEIGHT - 1 - my; oy = mx;
+                        } else if(rotation == ROTATE_180) {
+                            ox = MATRIX_WIDTH - 1 - mx; oy = MATRIX_HEIGHT - 1 - my;
+                        } else if(rotation == ROTATE_270) {
+                            ox = my; oy = MATRIX_WIDTH - 1 - mx;
+                        }
+                        for(uint16_t k = 0; k < scale * scale; k++) {
+                            if(getOutputPixel(&out, ox * scale + k % scale, oy * scale + k / scale) != (frame[y][x] != 0)) {
+                                isMatch = false;
+                            }
+                        }
+                    }
+                }
+                checked++;
+                if(!isMatch) {
+                    printf("Transform rotation=%d mirrorH=%d mirrorV=%d scale=%d failed.\n", 
+                           rotation * 90, transform.isMirrorH, transform.isMirrorV, scale);
+                    failures++;
+                }
+            }
+        }
+    }
+
+    output_transform_t identity = {ROTATE_0, false, false, 1};
+    setOutputTransform(&identity);
+    printf("Transform test: %u transforms checked, %s.\n", checked, failures == 0 ? "passed" : "failed");
+    return failures;
+}
+
+static uint32_t checkFrameColors(const char *name, color_index_t digitColor, color_index_t pos4Color)
+{
+    matrix_row_t rows[MATRIX_HEIGHT] = {0};
+    matrix_row_t colors[COLOR_BITS][MATRIX_HEIGHT] = {0};
+    uint32_t mismatches = 0;
+
+    getMatrixRows(rows);
+    getMatrixColors(colors);
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+            color_index_t expected = digitColor;
+            color_index_t actual = 0;
+            if(((rows[i] >> j) & 1U) == 0) {
+                expected = 0;
+            } else if(i == referenceOrigins[ALARM_DOT][0] && j == referenceOrigins[ALARM_DOT][1]) {
+                expected = 2;
+            } else if(j >= referenceOrigins[POS4][1]) {
+                expected = pos4Color;
+            }
+            for(uint8_t b = 0; b < COLOR_BITS; b++) {
+                actual |= (color_index_t)(((colors[b][i] >> j) & 1U) << b);
+            }
+            mismatches += (expected != actual);
+        }
+    }
+    if(mismatches != 0) {
+        printf("Palette %s: %u pixels with the wrong color.\n", name, mismatches);
+        return 1;
+    }
+    return 0;
+}
+
+static uint32_t runPaletteTest(void)
+{
+    static output_frame_t lit;
+    static output_frame_t planes[COLOR_BITS];
+    static output_frame_t dimming[DIMMING_BITS];
+    static uint8_t pixels[PANEL_BUFFER_SIZE];
+    matrix_row_t rows[MATRIX_HEIGHT] = {0};
+    matrix_row_t colors[COLOR_BITS][MATRIX_HEIGHT] = {0};
+    matrix_row_t dimRows[DIMMING_BITS][MATRIX_HEIGHT] = {0};
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    uint32_t failures = 0;
+    uint32_t checked = 0;
+
+    // 88:88 in color 1, alarm dot in color 2 and a replacing overlay 1 at POS4 in color 3
+    compositorInit();
+    layerSetColor(LAYER_TIME, 1);
+    layerSetColor(LAYER_STATUS, 2);
+    layerSetColor(LAYER_OVERLAY, 3 % PALETTE_SIZE);
+    for(char_pos_t position = POS1; position <= POS4; position++) {
+        layerSetCharacter(LAYER_TIME, position == COLON ? COLON_CHAR : EIGHT_CHAR, position);
+    }
+    layerSetCharacter(LAYER_STATUS, ALARM_CHAR_SET, ALARM_DOT);
+    layerClear(LAYER_OVERLAY);
+    layerSetCharacter(LAYER_OVERLAY, ONE_CHAR, POS4);
+    compositeLayers();
+    failures += checkFrameColors("replace", 1, 3 % PALETTE_SIZE);
+
+    // A mask keeps the colors of what it lets through (the part of the 8 under the 1), hiding it 
+    // brings back the whole 8 in color 1
+    layerSetBlendMode(LAYER_OVERLAY, BLEND_MASK);
+    compositeLayers();
+    failures += checkFrameColors("mask", 1, 1);
+    layerSetVisible(LAYER_OVERLAY, false);
+    compositeLayers();
+    failures += checkFrameColors("hidden overlay", 1, 1);
+
+    // A color change alone is blended again, and rendered ahead without touching the LED matrix
+    layerSetColor(LAYER_TIME, 0);
+    compositeLayersToRows(rows, colors);
+    failures += checkFrameColors("back buffer", 1, 1);
+    setMatrixRows(rows);
+    setMatrixColors(colors);
+    compositeLayers();
+    if(compositorGetBlendCount() != 0 || checkFrameColors("color change", 0, 0) != 0 ||
+       layerSetColor(LAYER_TIME, PALETTE_SIZE) != LED_ARG_ERROR) {
+        printf("Palette layer color change failed.\n");
+        failures++;
+    }
+
+    // Themes set the palette and the layer colors
+    if(paletteApplyTheme("contrast") != LED_OK || paletteApplyTheme("plaid") != LED_ARG_ERROR ||
+       paletteGetColor(0).g != 255 || paletteGetColor(1).g != 0 || paletteSetColor(PALETTE_SIZE, paletteGetColor(0)) != LED_ARG_ERROR) {
+        printf("Palette themes failed.\n");
+        failures++;
+    }
+    for(color_index_t i = 0; i < PALETTE_SIZE; i++) {
+        paletteSetColor(i, (rgb_color_t){.r = (uint8_t)(17 + 40 * i), .g = (uint8_t)(250 - 30 * i), .b = (uint8_t)(9 * i)});
+    }
+
+    // Random frames and colors through random transforms, in both formats, every other one dimmed
+    for(uint32_t trial = 0; trial < 256; trial++) {
+        output_transform_t transform = {(rotation_t)(trial % NUM_ROTATIONS), (trial & 4) != 0, (trial & 8) != 0,
+                                        (uint8_t)(1 + (trial / 16) % TRANSFORM_MAX_SCALE)};
+        color_format_t format = (color_format_t)((trial / 2) % NUM_COLOR_FORMATS);
+        uint8_t bytesPerPixel = paletteGetBytesPerPixel(format);
+        bool isDimmed = (trial & 1) != 0;
+        bool isMatch = true;
+
+        for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+            for(uint8_t b = 0; b <= COLOR_BITS; b++) {
+                seed ^= seed << 13;
+                seed ^= seed >> 7;
+                seed ^= seed << 17;
+                if(b == COLOR_BITS) {
+                    rows[i] = (matrix_row_t)seed & MATRIX_ROW_ALL;
+                } else {
+                    colors[b][i] = (matrix_row_t)(seed >> 32) & MATRIX_ROW_ALL;
+                }
+            }
+            for(uint8_t b = 0; b < DIMMING_BITS; b++) {
+                seed ^= seed << 13;
+                seed ^= seed >> 7;
+                seed ^= seed << 17;
+                dimRows[b][i] = (matrix_row_t)seed & MATRIX_ROW_ALL;
+            }
+        }
+        setOutputTransform(&transform);
+        paletteSetOutputFormat(format);
+        transformFrame(rows, &lit);
+        for(uint8_t b = 0; b < COLOR_BITS; b++) {
+            transformFrame(colors[b], &planes[b]);
+        }
+        for(uint8_t b = 0; b < DIMMING_BITS; b++) {
+            transformFrame(dimRows[b], &dimming[b]);
+        }
+        size_t written = paletteConvertFrame(&lit, planes, isDimmed ? dimming : NULL, pixels);
+        if(written != (size_t)lit.width * lit.height * bytesPerPixel) {
+            isMatch = false;
+        }
+
+        for(uint16_t y = 0; y < lit.height && isMatch; y++) {
+            for(uint16_t x = 0; x < lit.width && isMatch; x++) {
+                const uint8_t *pixel = &pixels[((size_t)y * lit.width + x) * bytesPerPixel];
+                rgb_color_t color = {0};
+                if(getOutputPixel(&lit, x, y)) {
+                    color_index_t index = 0;
+                    for(uint8_t b = 0; b < COLOR_BITS; b++) {
+                        index |= (color_index_t)(getOutputPixel(&planes[b], x, y) << b);
+                    }
+                    color = paletteGetColor(index);
+                    uint16_t level = LED_BRIGHTNESS_MAX;
+                    for(uint8_t b = 0; b < DIMMING_BITS && isDimmed; b++) {
+                        level -= (uint16_t)(getOutputPixel(&dimming[b], x, y) << b);
+                    }
+                    color.r = (uint8_t)(color.r * level / LED_BRIGHTNESS_MAX);
+                    color.g = (uint8_t)(color.g * level / LED_BRIGHTNESS_MAX);
+                    color.b = (uint8_t)(color.b * level / LED_BRIGHTNESS_MAX);
+                }
+                if(format == COLOR_FORMAT_RGB565) {
+                    uint16_t rgb565 = (uint16_t)((pixel[0] << 8) | pixel[1]);
+                    isMatch = (rgb565 >> 11) == (color.r >> 3) && ((rgb565 >> 5) & 0x3F) == (color.g >> 2) &&
+                              (rgb565 & 0x1F) == (color.b >> 3);
+                } else {
+                    isMatch = pixel[0] == color.r && pixel[1] == color.g && pixel[2] == color.b;
+                }
+            }
+        }
+        checked++;
+        if(!isMatch) {
+            printf("Palette conversion trial %u (rotation=%d scale=%d format=%d) failed.\n", 
+                   trial, transform.rotation * 90, transform.scale, format);
+            failures++;
+        }
+    }
+
+    // Back to the defaults for the tests that follow
+    output_transform_t identity = {ROTATE_0, false, false, 1};
+    setOutputTransform(&identity);
+    paletteSetOutputFormat(COLOR_FORMAT_RGB565);
+    compositorInit();
+    paletteApplyTheme("classic");
+    clearMatrix();
+    printf("Palette test: %u conversions checked, %s.\n", checked, failures == 0 ? "passed" : "failed");
+    return failures;
+}
+
+static uint32_t runWearTest(void)
+{
+    static uint64_t expected[MATRIX_HEIGHT][MATRIX_WIDTH];
+    static uint64_t onTicks[MATRIX_HEIGHT][MATRIX_WIDTH];
+    static uint8_t levels[MATRIX_HEIGHT][MATRIX_WIDTH];
+    matrix_row_t rows[MATRIX_HEIGHT] = {0};
+    matrix_row_t shown[MATRIX_HEIGHT] = {0};
+    matrix_row_t shifted[MATRIX_HEIGHT] = {0};
+    uint64_t seed = 0xD1B54A32D192ED03ULL;
+    uint64_t tickNsec = 0;
+    uint64_t expectedTotal = 0;
+    uint64_t total = 0;
+    bool isShown = false;
+    wear_stats_t stats = {0};
+    uint32_t failures = 0;
+
+    unlink(WEAR_TEST_PATH);
+    if(wearOpen(WEAR_TEST_PATH) != LED_OK) {
+        printf("Wear test could not open %s.\n", WEAR_TEST_PATH);
+        return 1;
+    }
+    memset(expected, 0, sizeof(expected));
+
+    // Most frames are shown for less than a tick, some for many ticks and a few for longer than 
+    // the counters hold. Halfway the file is reopened, the frame shown until then is counted by the 
+    // close and accounting starts over with the next frame.
+    for(uint32_t frame = 0; frame < WEAR_TEST_FRAMES; frame++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+            rows[i] = (matrix_row_t)(seed >> (i * 5)) & MATRIX_ROW_ALL;
+        }
+        uint64_t pick = (seed >> 40) % 1000;
+        uint64_t stepNsec = pick < 700 ? (seed >> 20) % WEAR_TEST_TICK_NSEC :
+                            pick < 998 ? (seed >> 20) % (50 * WEAR_TEST_TICK_NSEC) :
+                                         ((1ULL << WEAR_SLICE_BITS) + (seed >> 20) % 1000) * WEAR_TEST_TICK_NSEC;
+        uint64_t ticks = (tickNsec + stepNsec) / WEAR_TEST_TICK_NSEC - tickNsec / WEAR_TEST_TICK_NSEC;
+        tickNsec += stepNsec;
+        if(frame == WEAR_TEST_FRAMES / 2) {
+            ticks += WEAR_TEST_CLOSE_TICKS;
+            tickNsec += WEAR_TEST_CLOSE_TICKS * WEAR_TEST_TICK_NSEC;
+        }
+
+        for(uint8_t i = 0; i < MATRIX_HEIGHT && isShown; i++) {
+            for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+                expected[i][j] += ((shown[i] >> j) & 1U) ? ticks : 0;
+            }
+        }
+        expectedTotal += isShown ? ticks : 0;
+        if(frame == WEAR_TEST_FRAMES / 2) {
+            wearClose(tickNsec);
+            wearOpen(WEAR_TEST_PATH);
+        }
+        wearRecordFrame(rows, tickNsec);
+        memcpy(shown, rows, sizeof(shown));
+        isShown = true;
+    }
+    wearGetStats(&stats);
+    if(wearGetOnTime(onTicks, &total) != LED_OK || memcmp(onTicks, expected, sizeof(expected)) != 0 ||
+       total != expectedTotal || stats.frames != WEAR_TEST_FRAMES - WEAR_TEST_FRAMES / 2) {
+        printf("Wear on-time failed (%llu of %llu ticks).\n", (unsigned long long)total, (unsigned long long)expectedTotal);
+        failures++;
+    }
+
+    // The digits and colon move with the layout offset, the alarm dot stays in its corner
+    memset(rows, 0, sizeof(rows));
+    for(char_pos_t position = POS1; position <= POS4; position++) {
+        setCharacterInRows(position == COLON ? COLON_CHAR : EIGHT_CHAR, position, rows, NULL);
+    }
+    if(setLayoutOffset(1, -1) != LED_ARG_ERROR || setLayoutOffset(2, 0) != LED_ARG_ERROR || setLayoutOffset(-1, 1) != LED_OK) {
+        printf("Wear layout offset limits failed.\n");
+        failures++;
+    }
+    for(char_pos_t position = POS1; position <= ALARM_DOT; position++) {
+        setCharacterInRows(position == COLON ? COLON_CHAR : position == ALARM_DOT ? ALARM_CHAR_SET : EIGHT_CHAR, position, shifted, NULL);
+    }
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        matrix_row_t expectedRow = (i == 0 ? 0 : rows[i - 1] >> 1) | (i == 0 ? (matrix_row_t)1U << (MATRIX_WIDTH - 1) : 0);
+        if(shifted[i] != expectedRow) {
+            printf("Wear layout offset row %u failed.\n", i);
+            failures++;
+        }
+    }
+
+    // A fresh file where the default layout showed 88:88 for a while: shifting moves to the least 
+    // worn layout, dimming takes the most worn LEDs down to WEAR_MIN_BRIGHTNESS
+    wearClose(tickNsec);
+    unlink(WEAR_TEST_PATH);
+    wearOpen(WEAR_TEST_PATH);
+    setLayoutOffset(0, 0);
+    wearRecordFrame(rows, 0);
+    wearRecordFrame(rows, 1000 * WEAR_TEST_TICK_NSEC);
+    wearGetOnTime(onTicks, NULL);
+
+    uint64_t leastWear = UINT64_MAX;
+    uint64_t chosenWear = UINT64_MAX;
+    int8_t col = 0;
+    int8_t row = 0;
+    wearApplyLeveling(WEAR_LEVEL_SHIFT);
+    getLayoutOffset(&col, &row);
+    for(int8_t r = -LAYOUT_MAX_OFFSET; r <= LAYOUT_MAX_OFFSET; r++) {
+        for(int8_t c = -LAYOUT_MAX_OFFSET; c <= LAYOUT_MAX_OFFSET; c++) {
+            uint64_t wear = 0;
+            if(getLayoutCoverage(c, r, shifted) != LED_OK) {
+                continue;
+            }
+            for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+                for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+                    wear += ((shifted[i] >> j) & 1U) ? onTicks[i][j] : 0;
+                }
+            }
+            leastWear = wear < leastWear ? wear : leastWear;
+            chosenWear = (c == col && r == row) ? wear : chosenWear;
+        }
+    }
+    if((col == 0 && row == 0) || chosenWear != leastWear) {
+        printf("Wear shift leveling failed, chose (%d, %d).\n", col, row);
+        failures++;
+    }
+
+    wearApplyLeveling(WEAR_LEVEL_DIM);
+    getLedBrightness(levels);
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+            if(levels[i][j] != (onTicks[i][j] != 0 ? WEAR_MIN_BRIGHTNESS : LED_BRIGHTNESS_MAX)) {
+                printf("Wear dim leveling failed at (%u, %u): %u.\n", i, j, levels[i][j]);
+                failures++;
+            }
+        }
+    }
+
+    // No leveling goes back to the defaults
+    wearApplyLeveling(WEAR_LEVEL_NONE);
+    getLayoutOffset(&col, &row);
+    getLedBrightness(levels);
+    if(col != 0 || row != 0 || levels[0][0] != LED_BRIGHTNESS_MAX || levels[1][1] != LED_BRIGHTNESS_MAX ||
+       wearApplyLeveling(NUM_WEAR_POLICIES) != LED_ARG_ERROR) {
+        printf("Wear leveling reset failed.\n");
+        failures++;
+    }
+    wearClose(1000 * WEAR_TEST_TICK_NSEC);
+
+    // Files that are not wear files for this panel are refused and left as they were: 
+    // the wear file with its header broken, then a text file
+    for(uint8_t attempt = 0; attempt < 2; attempt++) {
+        static uint8_t before[8192];
+        static uint8_t after[8192];
+        size_t beforeSize = 0;
+        size_t afterSize = 0;
+        FILE *file = fopen(WEAR_TEST_PATH, attempt == 0 ? "r+b" : "wb");
+        if(file != NULL) {
+            fputs(attempt == 0 ? "X" : "not a wear file\n", file);
+            fclose(file);
+        }
+        file = fopen(WEAR_TEST_PATH, "rb");
+        beforeSize = file != NULL ? fread(before, 1, sizeof(before), file) : 0;
+        if(file != NULL) {
+            fclose(file);
+        }
+        led_matrix_err_t status = wearOpen(WEAR_TEST_PATH);
+        file = fopen(WEAR_TEST_PATH, "rb");
+        afterSize = file != NULL ? fread(after, 1, sizeof(after), file) : 0;
+        if(file != NULL) {
+            fclose(file);
+        }
+        if(status != LED_IO_ERROR || beforeSize == 0 || afterSize != beforeSize || memcmp(before, after, beforeSize) != 0) {
+            printf("Wear open of a foreign file failed (status %d, %zu bytes before, %zu after).\n", status, beforeSize, afterSize);
+            failures++;
+            wearClose(0);
+        }
+    }
+    unlink(WEAR_TEST_PATH);
+    if(wearFlush() != LED_ARG_ERROR) {
+        printf("Wear flush while closed failed.\n");
+        failures++;
+    }
+    printf("Wear test: %u frames accounted, %s.\n", WEAR_TEST_FRAMES, failures == 0 ? "passed" : "failed");
+    return failures;
+}
+
+static uint32_t checkWorldClockTimes(time_t start, time_t end, uint64_t *checked)
+{
+    uint32_t failures = 0;
+
+    for(uint16_t zone = 0; zone < worldClockGetZoneCount(); zone++) {
+        int32_t lastOffset = 0;
+        setenv("TZ", worldClockGetZoneName(zone), 1);
+        tzset();
+
+        for(time_t t = start; t < end; t += WORLD_TEST_STEP_SEC) {
+            // Samples every step and, when the offset changed, every second on both sides of the change
+            time_t lo = t, hi = t;
+            struct tm local;
+            localtime_r(&t, &local);
+            if(t != start && local.tm_gmtoff != lastOffset) {
+                lo = t - WORLD_TEST_STEP_SEC;
+                while(hi - lo > 1) {
+                    time_t mid = lo + (hi - lo) / 2;
+                    localtime_r(&mid, &local);
+                    if(local.tm_gmtoff == lastOffset) {
+                        lo = mid;
+                    } else {
+                        hi = mid;
+                    }
+                }
+                lo -= 2;
+                hi += 2;
+            }
+            for(time_t sample = lo; sample <= hi; sample++) {
+                world_time_t worldTime = {0};
+                localtime_r(&sample, &local);
+                worldClockGetTime(zone, sample, &worldTime);
+                (*checked)++;
+                if(worldTime.hour != local.tm_hour || worldTime.minute != local.tm_min || worldTime.utcOffsetSec != local.tm_gmtoff) {
+                    printf("World clock %s at %lld: got %02d:%02d, expected %02d:%02d\n", worldClockGetZoneName(zone),
+                           (long long)sample, worldTime.hour, worldTime.minute, local.tm_hour, local.tm_min);
+                    failures++;
+                    break;
+                }
+            }
+            localtime_r(&t, &local);
+            lastOffset = (int32_t)local.tm_gmtoff;
+        }
+    }
+    return failures;
+}
+
+static uint32_t runWorldClockTest(void)
+{
+    character_t label[WORLD_LABEL_CHARS];
+    uint32_t failures = 0;
+    uint64_t checked = 0;
+    time_t start = time(NULL);
+    time_t end = start + (WORLD_CLOCK_HORIZON_DAYS - 2) * 86400LL;
+
+    if(worldClockLoadZones(WORLD_TEST_ZONES) != LED_OK || worldClockLoadZones("Nowhere/Atlantis") != LED_ARG_ERROR ||
+       worldClockLoadZones("../zoneinfo/UTC") != LED_ARG_ERROR || worldClockLoadZones("/etc/localtime") != LED_ARG_ERROR) {
+        printf("World clock failed to load zones.\n");
+        worldClockClear();
+        return 1;
+    }
+    // Paris and Berlin have had the same rules for decades
+    if(worldClockGetZoneCount() != 11 || worldClockGetTableCount() >= worldClockGetZoneCount()) {
+        printf("World clock has %u zones in %u tables\n", worldClockGetZoneCount(), worldClockGetTableCount());
+        failures++;
+    }
+
+    // Explicit and derived labels
+    worldClockGetLabel(0, label);
+    if(label[0] != N_CHAR || label[1] != Y_CHAR || label[2] != C_CHAR || label[3] != NUM_CHARACTERS) {
+        failures++;
+    }
+    worldClockGetLabel(7, label);
+    if(label[0] != S_CHAR || label[1] != T_CHAR || label[2] != J_CHAR || label[3] != O_CHAR) {
+        failures++;
+    }
+
+    failures += checkWorldClockTimes(start, end, &checked);
+
+    // Rebuilding far ahead uses the rules at the end of the zone files, past their last transition
+    if(worldClockRefresh(start) != LED_OK || worldClockRefresh(end + WORLD_TEST_REFRESH_YEARS * 365LL * 86400LL) != LED_OK) {
+        printf("World clock failed to rebuild the tables.\n");
+        failures++;
+    }
+    failures += checkWorldClockTimes(end + WORLD_TEST_REFRESH_YEARS * 365LL * 86400LL, 
+                                     end + WORLD_TEST_REFRESH_YEARS * 365LL * 86400LL + (end - start), &checked);
+    unsetenv("TZ");
+    tzset();
+    worldClockClear();
+
+    printf("World clock test: %llu times checked, %s.\n", (unsigned long long)checked, failures == 0 ? "passed" : "failed");
+    return failures;
+}
+
+static uint32_t runAnimatorTest(void)
+{
+    uint32_t failures = 0;
+    uint8_t cell[SPRITE_HEIGHT];
+
+    for(int transition = TRANSITION_SLIDE; transition < NUM_TRANSITIONS; transition++) {
+        animatorInit((transition_t)transition);
+        for(uint8_t from = 0; from < 10; from++) {
+            for(uint8_t to = 0; to < 10; to++) {
+                const char *const *oldGlyph = referenceGlyphs[ZERO_CHAR + from];
+                const char *const *newGlyph = referenceGlyphs[ZERO_CHAR + to];
+                uint16_t lastSwitched = 0;
+                bool isMatch = true;
+
+                for(uint8_t step = 0; step <= ANIM_STEPS && isMatch; step++) {
+                    animatorGetTransitionCell((character_t)(ZERO_CHAR + from), (character_t)(ZERO_CHAR + to), step, cell);
+                    uint16_t switched = 0;
+                    for(uint8_t i = 0; i < SPRITE_HEIGHT; i++) {
+                        for(uint8_t j = 0; j < SPRITE_WIDTH; j++) {
+                            bool pixel = (cell[i] >> j) & 1;
+                            bool expected = false;
+                            if(transition == TRANSITION_SLIDE) {
+                                // Old glyph, a blank column, then the new glyph, moving left
+                                uint8_t col = j + (step * 4 + ANIM_STEPS / 2) / ANIM_STEPS;
+                                expected = col < 3 ? oldGlyph[i][col] == '#' : (col > 3 && newGlyph[i][col - 4] == '#');
+                            } else if(transition == TRANSITION_ROLL) {
+                                // Old glyph, a blank row, then the new glyph, moving up
+                                uint8_t row = i + (step * 6 + ANIM_STEPS / 2) / ANIM_STEPS;
+                                expected = row < 5 ? oldGlyph[row][j] == '#' : (row > 5 && newGlyph[row - 6][j] == '#');
+                            } else {
+                                // Where the glyphs differ a pixel switches to the new glyph once and stays
+                                uint16_t bit = (uint16_t)(1U << (i * 3 + j));
+                                bool isOldPixel = oldGlyph[i][j] == '#';
+                                bool isNewPixel = newGlyph[i][j] == '#';
+                                expected = (lastSwitched & bit) != 0 ? isNewPixel : pixel;
+                                if(pixel != isOldPixel && pixel != isNewPixel) {
+                                    expected = isOldPixel;
+                                }
+                                if(isOldPixel != isNewPixel && pixel == isNewPixel) {
+                                    switched |= bit;
+                                }
+                            }
+                            if(pixel != expected) {
+                                isMatch = false;
+                            }
+                        }
+                    }
+                    lastSwitched |= switched;
+                }
+                // Last frame is the new glyph
+                for(uint8_t i = 0; i < SPRITE_HEIGHT && isMatch; i++) {
+                    for(uint8_t j = 0; j < SPRITE_WIDTH; j++) {
+                        if(((cell[i] >> j) & 1) != (newGlyph[i][j] == '#')) {
+                            isMatch = false;
+                        }
+                    }
+                }
+                if(!isMatch) {
+                    printf("Animation %d from %d to %d failed.\n", transition, from, to);
+                    failures++;
+                }
+            }
+        }
+    }
+
+    // Timing: the first character is instant, a change animates for ANIM_STEPS frames
+    matrix_row_t rows[MATRIX_HEIGHT] = {0};
+    matrix_row_t expectedRows[MATRIX_HEIGHT] = {0};
+    uint64_t start = 5 * NSEC_PER_SEC;
+    uint64_t end = start + (ANIM_STEPS - 1) * ANIM_FRAME_NSEC;
+    animatorInit(TRANSITION_SLIDE);
+    animatorSetCharacter(POS4, ONE_CHAR, 0);
+    if(animatorIsActive(0)) {
+        failures++;
+    }
+    animatorSetCharacter(POS4, TWO_CHAR, start);
+    animatorRender(start, rows, NULL);
+    animatorGetTransitionCell(ONE_CHAR, TWO_CHAR, 1, cell);
+    setCellInRows(POS4, cell, expectedRows, NULL);
+    if(!animatorIsActive(end - 1) || animatorIsActive(end) || animatorGetNextFrameNsec(start + 1) != start + ANIM_FRAME_NSEC ||
+       memcmp(rows, expectedRows, sizeof(rows)) != 0) {
+        printf("Animation timing failed.\n");
+        failures++;
+    }
+    animatorRender(end, rows, NULL);
+    setCharacterInRows(TWO_CHAR, POS4, expectedRows, NULL);
+    if(memcmp(rows, expectedRows, sizeof(rows)) != 0) {
+        printf("Animation did not end on the new glyph.\n");
+        failures++;
+    }
+    animatorInit(TRANSITION_NONE);
+
+    printf("Animator test %s.\n", failures == 0 ? "passed" : "failed");
+    return failures;
+}
+
+static void *traceTestThread(void *ptr)
+{
+    (void)ptr;
+    traceSetThreadName("trace test");
+    for(uint32_t i = 0; i < TRACE_TEST_PAIRS; i++) {
+        TRACE_BEGIN("work");
+        TRACE_END("work");
+    }
+    return NULL;
+}
+
+static uint32_t runTraceTest(void)
+{
+    pthread_t threads[TRACE_TEST_THREADS];
+    uint64_t lastTs[TRACE_TEST_THREADS + 1] = {0};
+    uint64_t begins = 0, ends = 0;
+    uint32_t failures = 0;
+    trace_stats_t stats = {0};
+    char line[256];
+    FILE *file = NULL;
+
+    traceSetEnabled(true);
+    for(uint32_t t = 0; t < TRACE_TEST_THREADS; t++) {
+        pthread_create(&threads[t], NULL, traceTestThread, NULL);
+    }
+    // Dumping while the threads are still recording must not block them or write torn events
+    if(traceWriteJson(TRACE_TEST_PATH) != LED_OK) {
+        failures++;
+    }
+    for(uint32_t t = 0; t < TRACE_TEST_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    traceSetEnabled(false);
+
+    // Nothing is recorded while tracing is off
+    TRACE_INSTANT("ignored");
+    traceGetStats(&stats);
+    if(stats.threads != TRACE_TEST_THREADS || stats.eventsRecorded != TRACE_TEST_THREADS * TRACE_TEST_PAIRS * 2ULL ||
+       stats.eventsOverwritten != TRACE_TEST_THREADS * (TRACE_TEST_PAIRS * 2ULL - TRACE_RING_EVENTS)) {
+        printf("Trace stats wrong: %u threads, %llu events, %llu overwritten\n", stats.threads,
+               (unsigned long long)stats.eventsRecorded, (unsigned long long)stats.eventsOverwritten);
+        failures++;
+    }
+
+    if(traceWriteJson(TRACE_TEST_PATH) != LED_OK || (file = fopen(TRACE_TEST_PATH, "r")) == NULL) {
+        printf("Trace test could not write the trace.\n");
+        return failures + 1;
+    }
+    // One event per line. The last TRACE_RING_EVENTS events of each thread are kept, 
+    // which starts on a begin since every thread recorded an even number of events.
+    while(fgets(line, sizeof(line), file) != NULL) {
+        char phase = 0;
+        unsigned int tid = 0;
+        unsigned long long usec = 0, nsec = 0;
+        if(sscanf(line, "{\"ph\":\"%c\",\"name\":\"work\",\"pid\":1,\"tid\":%u,\"ts\":%llu.%llu", &phase, &tid, &usec, &nsec) == 4) {
+            uint64_t ts = usec * 1000 + nsec;
+            if(tid == 0 || tid > TRACE_TEST_THREADS || ts < lastTs[tid]) {
+                failures++;
+                continue;
+            }
+            lastTs[tid] = ts;
+            begins += (phase == 'B');
+            ends += (phase == 'E');
+        }
+    }
+    fclose(file);
+    unlink(TRACE_TEST_PATH);
+
+    if(begins != ends || begins + ends != (uint64_t)TRACE_TEST_THREADS * TRACE_RING_EVENTS) {
+        printf("Trace JSON has %llu begin and %llu end events\n", (unsigned long long)begins, (unsigned long long)ends);
+        failures++;
+    }
+    traceReset();
+
+    printf("Trace test %s.\n", failures == 0 ? "passed" : "failed");
+    return failures;
+}
+
+static led_matrix_err_t ctrlTestSetAlarm(bool isSet, uint8_t hour, uint8_t minute)
+{
+    (void)isSet;
+    ctrlTest.alarmCalls++;
+    return (hour > 23 || minute > 59) ? LED_ARG_ERROR : LED_OK;
+}
+
+static led_matrix_err_t ctrlTestSetMode(uint8_t mode)
+{
+    ctrlTest.modeCalls++;
+    ctrlTest.lastMode = mode;
+    return LED_OK;
+}
+
+static void ctrlTestGetState(ctrl_state_t *state)
+{
+    state->mode = ctrlTest.lastMode;
+    state->alarmHour = 5;
+    state->alarmMinute = 30;
+}
+
+static led_matrix_err_t ctrlTestPushFrame(const matrix_row_t rows[MATRIX_HEIGHT])
+{
+    ctrlTest.frameCalls++;
+    memcpy(ctrlTest.lastFrame, rows, sizeof(ctrlTest.lastFrame));
+    return LED_OK;
+}
+
+static size_t appendControlMessage(uint8_t *buf, size_t len, uint8_t opcode, const void *payload, uint16_t length)
+{
+    ctrl_header_t header = {.opcode = opcode, .length = length};
+    memcpy(&buf[len], &header, CTRL_HEADER_SIZE);
+    if(length > 0) {
+        memcpy(&buf[len + CTRL_HEADER_SIZE], payload, length);
+    }
+    return len + CTRL_HEADER_SIZE + length;
+}
+
+static uint32_t runControlServerTest(void)
+{
+    // Each round is 4 commands, none longer than a frame push, plus the final query
+    static uint8_t batch[CTRL_TEST_ROUNDS * 4 * (CTRL_HEADER_SIZE + sizeof(matrix_row_t) * MATRIX_HEIGHT) + CTRL_HEADER_SIZE];
+    const ctrl_handlers_t handlers = {
+        .setAlarm = ctrlTestSetAlarm,
+        .setMode = ctrlTestSetMode,
+        .getState = ctrlTestGetState,
+        .pushFrame = ctrlTestPushFrame
+    };
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    int clientFds[CTRL_TEST_CLIENTS];
+    ctrl_stats_t stats = {0};
+    uint32_t failures = 0;
+    size_t len = 0;
+
+#if !defined(__linux__)
+    printf("Control server test skipped, the control socket is Linux only.\n");
+    return 0;
+#endif
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "/tmp/matrixclock_test_%d.sock", (int)getpid());
+
+    // A path that names anything but a socket is left alone
+    FILE *file = fopen(addr.sun_path, "w");
+    if(file != NULL) {
+        fclose(file);
+        led_matrix_err_t status = controlServerStart(addr.sun_path, &handlers);
+        if(status != LED_IO_ERROR || access(addr.sun_path, F_OK) != 0) {
+            printf("Control server test replaced a regular file at the socket path.\n");
+            failures++;
+        }
+        if(status == LED_OK) {
+            controlServerStop();
+        }
+        unlink(addr.sun_path);
+    }
+
+    memset(&ctrlTest, 0, sizeof(ctrlTest));
+    if(controlServerStart(addr.sun_path, &handlers) != LED_OK) {
+        printf("Control server test failed to start.\n");
+        return 1;
+    }
+
+    // Every client sends the same batch: alarm, mode, two frames (one gets coalesced), then a query
+    for(uint32_t round = 0; round < CTRL_TEST_ROUNDS; round++) {
+        ctrl_alarm_t alarm = {.hour = 5, .minute = 30};
+        ctrl_mode_t mode = {.mode = (uint8_t)(round % 3)};
+        matrix_row_t frame[MATRIX_HEIGHT] = {0};
+        len = appendControlMessage(batch, len, CTRL_CMD_SET_ALARM, &alarm, sizeof(alarm));
+        len = appendControlMessage(batch, len, CTRL_CMD_SET_MODE, &mode, sizeof(mode));
+        frame[0] = round;
+        len = appendControlMessage(batch, len, CTRL_CMD_PUSH_FRAME, frame, sizeof(frame));
+        frame[0] = MATRIX_ROW_ALL;
+        len = appendControlMessage(batch, len, CTRL_CMD_PUSH_FRAME, frame, sizeof(frame));
+    }
+    len = appendControlMessage(batch, len, CTRL_CMD_QUERY_STATE, NULL, 0);
+
+    uint64_t start = getMonotonicNsec(TICK_SOURCE_PRECISE);
+    for(uint32_t i = 0; i < CTRL_TEST_CLIENTS; i++) {
+        clientFds[i] = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(connect(clientFds[i], (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+           send(clientFds[i], batch, len, 0) != (ssize_t)len) {
+            printf("Control server test client %u could not connect/send.\n", i);
+            failures++;
+        }
+    }
+
+    // Each client gets exactly one reply, the state
+    for(uint32_t i = 0; i < CTRL_TEST_CLIENTS; i++) {
+        uint8_t reply[CTRL_HEADER_SIZE + sizeof(ctrl_state_t)] = {0};
+        ctrl_header_t header = {0};
+        ctrl_state_t state = {0};
+        struct timeval timeout = {.tv_sec = 2};
+        setsockopt(clientFds[i], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        if(recv(clientFds[i], reply, sizeof(reply), MSG_WAITALL) != (ssize_t)sizeof(reply)) {
+            printf("Control server test client %u got no reply.\n", i);
+            failures++;
+            continue;
+        }
+        memcpy(&header, reply, CTRL_HEADER_SIZE);
+        memcpy(&state, &reply[CTRL_HEADER_SIZE], sizeof(state));
+        if(header.opcode != CTRL_RSP_STATE || header.length != sizeof(ctrl_state_t) ||
+           state.alarmHour != 5 || state.alarmMinute != 30) {
+            printf("Control server test client %u got a bad reply.\n", i);
+            failures++;
+        }
+    }
+    uint64_t elapsed = getMonotonicNsec(TICK_SOURCE_PRECISE) - start;
+
+    // A bad command gets an error reply
+    {
+        ctrl_alarm_t badAlarm = {.hour = 25};
+        uint8_t reply[CTRL_HEADER_SIZE + sizeof(ctrl_error_t)] = {0};
+        ctrl_error_t error = {0};
+        len = appendControlMessage(batch, 0, CTRL_CMD_SET_ALARM, &badAlarm, sizeof(badAlarm));
+        send(clientFds[0], batch, len, 0);
+        if(recv(clientFds[0], reply, sizeof(reply), MSG_WAITALL) != (ssize_t)sizeof(reply) || 
+           (memcpy(&error, &reply[CTRL_HEADER_SIZE], sizeof(error)), error.opcode != CTRL_CMD_SET_ALARM) ||
+           error.status != LED_ARG_ERROR) {
+            printf("Control server test got no error reply for a bad alarm.\n");
+            failures++;
+        }
+    }
+
+    // Pipelined queries are all answered, even though the replies overflow the reply buffer
+    {
+        static uint8_t replies[CTRL_TEST_QUERIES][CTRL_HEADER_SIZE + sizeof(ctrl_state_t)];
+        ssize_t received = 0;
+        len = 0;
+        for(uint32_t i = 0; i < CTRL_TEST_QUERIES; i++) {
+            len = appendControlMessage(batch, len, CTRL_CMD_QUERY_STATE, NULL, 0);
+        }
+        send(clientFds[1], batch, len, 0);
+        received = recv(clientFds[1], replies, sizeof(replies), MSG_WAITALL);
+        if(received != (ssize_t)sizeof(replies) || replies[CTRL_TEST_QUERIES - 1][0] != CTRL_RSP_STATE) {
+            printf("Control server test got %zd of %zu bytes of replies to pipelined queries.\n", received, sizeof(replies));
+            failures++;
+        }
+    }
+
+    for(uint32_t i = 0; i < CTRL_TEST_CLIENTS; i++) {
+        close(clientFds[i]);
+    }
+    controlServerStop();
+    controlServerGetStats(&stats);
+
+    uint64_t expectedCommands = (uint64_t)CTRL_TEST_CLIENTS * (CTRL_TEST_ROUNDS * 4 + 1) + 1 + CTRL_TEST_QUERIES;
+    if(stats.commands != expectedCommands || stats.errors != 1 ||
+       ctrlTest.alarmCalls != CTRL_TEST_CLIENTS * CTRL_TEST_ROUNDS + 1 ||
+       ctrlTest.modeCalls != CTRL_TEST_CLIENTS * CTRL_TEST_ROUNDS ||
+       stats.framesPushed != 2ULL * CTRL_TEST_CLIENTS * CTRL_TEST_ROUNDS ||
+       ctrlTest.frameCalls + stats.framesCoalesced != stats.framesPushed ||
+       ctrlTest.lastFrame[0] != MATRIX_ROW_ALL) {
+        printf("Control server test stats mismatch: %llu commands, %llu errors, %u frames handed over.\n",
+               (unsigned long long)stats.commands, (unsigned long long)stats.errors, ctrlTest.frameCalls);
+        failures++;
+    }
+
+    printf("Control server: %llu commands from %d clients in %.2f ms (%.0f commands/s), %llu wakeups, %llu frames coalesced.\n",
+           (unsigned long long)stats.commands, CTRL_TEST_CLIENTS, (double)elapsed / NSEC_PER_MSEC,
+           (double)stats.commands * NSEC_PER_SEC / (double)elapsed, (unsigned long long)stats.wakeups,
+           (unsigned long long)stats.framesCoalesced);
+    printf("Control server test %s.\n", failures == 0 ? "passed" : "failed");
+    return failures;
+}
+
+static led_matrix_err_t countingWriteRow(uint8_t row, const uint8_t pixels[MATRIX_WIDTH])
+{
+    matrix_row_t packed = 0;
+
+    for(uint8_t j = 0; j < MATRIX_WIDTH; j++) {
+        packed |= (matrix_row_t)(pixels[j] != 0) << j;
+    }
+    if(row == 0) {
+        scanTestScanRow = packed;
+    } else if(packed != scanTestScanRow) {
+        scanTestTornRows++;
+    }
+    scanTestRowWrites[row]++;
+    return LED_OK;
+}
+
+static led_matrix_err_t stallingWriteRow(uint8_t row, const uint8_t pixels[MATRIX_WIDTH])
+{
+    (void)pixels;
+    if(isScanTestStalled) {
+        if(scanTestRowsAfterStall[0] < 0) {
+            scanTestRowsAfterStall[0] = row;
+        } else if(scanTestRowsAfterStall[1] < 0) {
+            scanTestRowsAfterStall[1] = row;
+        }
+    } else if(row == 2 && scanTestRowWrites[0] >= SCAN_TEST_STALL_SCANS) {
+        // Hold the thread for several row periods once, as if it was preempted
+        isScanTestStalled = true;
+        sleepUntilMonotonicNsec(getMonotonicNsec(TICK_SOURCE_PRECISE) + 
+                                SCAN_TEST_STALL_ROWS * NSEC_PER_SEC / SCAN_DEFAULT_ROW_RATE_HZ);
+    }
+    scanTestRowWrites[row]++;
+    return LED_OK;
+}
+
+static uint32_t runScanRefreshTest(void)
+{
+    const scan_backend_t countingBackend = {.name = "counting", .writeRow = countingWriteRow};
+    const scan_config_t config = {
+        .rowRateHz = SCAN_DEFAULT_ROW_RATE_HZ,
+        .cpu = 0,
+        .priority = SCAN_DEFAULT_PRIORITY,
+        .isLockMemory = true
+    };
+    scan_stats_t stats = {0};
+    uint64_t totalWrites = 0;
+    uint32_t failures = 0;
+
+    if(scanRefreshStart(&countingBackend, &config) != LED_OK) {
+        printf("Scan refresh test failed to start.\n");
+        return 1;
+    }
+    // Publish frames as fast as possible while it scans, a scan mixing two frames has rows that differ
+    uint64_t endNsec = getMonotonicNsec(TICK_SOURCE_PRECISE) + SCAN_TEST_DURATION_MS * NSEC_PER_MSEC;
+    uint32_t published = 0;
+    while(getMonotonicNsec(TICK_SOURCE_PRECISE) < endNsec) {
+        matrix_row_t rows[MATRIX_HEIGHT];
+        published++;
+        for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+            rows[i] = (matrix_row_t)(published & ((1U << MATRIX_WIDTH) - 1));
+        }
+        scanRefreshPublishFrame(rows);
+    }
+    scanRefreshStop();
+    scanRefreshGetStats(&stats);
+
+    for(uint8_t i = 0; i < MATRIX_HEIGHT; i++) {
+        totalWrites += scanTestRowWrites[i];
+        if(scanTestRowWrites[i] == 0) {
+            failures++;
+        }
+    }
+    if(scanTestTornRows != 0) {
+        printf("Scan refresh wrote %llu rows from a different frame than the rest of their scan.\n",
+               (unsigned long long)scanTestTornRows);
+        failures++;
+    }
+    if(totalWrites != stats.rowsScanned || stats.framesScanned == 0 ||
+       stats.jitterP50Nsec > stats.jitterP99Nsec || stats.jitterP99Nsec > stats.jitterP999Nsec) {
+        failures++;
+    }
+
+    scanRefreshPrintStats();
+
+    // Row 3 wakes up late after a stall in row 2 and is still written, then the rows that 
+    // were due meanwhile are skipped and it picks back up at the row due now
+    const scan_backend_t stallingBackend = {.name = "stalling", .writeRow = stallingWriteRow};
+    memset(scanTestRowWrites, 0, sizeof(scanTestRowWrites));
+    if(scanRefreshStart(&stallingBackend, &config) != LED_OK) {
+        printf("Scan refresh test failed to start.\n");
+        return failures + 1;
+    }
+    sleepUntilMonotonicNsec(getMonotonicNsec(TICK_SOURCE_PRECISE) + SCAN_TEST_DURATION_MS * NSEC_PER_MSEC);
+    scanRefreshStop();
+    scanRefreshGetStats(&stats);
+    if(scanTestRowsAfterStall[0] != 3 || scanTestRowsAfterStall[1] == 4 || 
+       stats.rowMisses[3] == 0 || stats.rowMisses[4] == 0) {
+        printf("Scan refresh wrote rows %d, %d after a stall at row 2 (misses of rows 3 and 4: %llu, %llu).\n", 
+               scanTestRowsAfterStall[0], scanTestRowsAfterStall[1], 
+               (unsigned long long)stats.rowMisses[3], (unsigned long long)stats.rowMisses[4]);
+        failures++;
+    }
+
+    printf("Scan refresh test %s.\n", failures == 0 ? "passed" : "failed");
+    return failures;
+}
 
 int main(void) {
     uint8_t testMatrix[MATRIX_HEIGHT][MATRIX_WIDTH] = {0};
+    uint32_t failures = 0;
 
     for(uint8_t i =0; i < NUM_TEST_CASES; i++) {
         clearMatrix();
@@ -112,8 +1745,20 @@ int main(void) {
             printf("Test case %d passed.\n", i);
         } else {
             printf("Test case %d failed.\n", i);
+            failures++;
         }
     }
-    return 0;
+
+    failures += runGoldenFrameSweep();
+    failures += runCompositorTest();
+    failures += runTransformTest();
+    failures += runPaletteTest();
+    failures += runWearTest();
+    failures += runWorldClockTest();
+    failures += runAnimatorTest();
+    failures += runScanRefreshTest();
+    failures += runControlServerTest();
+    failures += runTraceTest();
+    return failures == 0 ? 0 : 1;
 }
 
@@ -0,0 +1,797 @@
+/** ********************************************************************************
+*@file worldClock.c
+*
+*@date March 5th, 2026
+*
+*@author julio.liriano (julio.liriano@gmail.com)
+*
+*@brief
+********************************************************************************
+
+/* Includes ------------------------------------------------------------------*/
+#include "worldClock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+/* Imported variables --------------------------------------------------------*/
+
+/* Imported function prototypes ----------------------------------------------*/
+
+/* Private constants ---------------------------------------------------------*/
+#define ZONEINFO_DIR "/usr/share/zoneinfo"
+#define ZONE_FILE_MAX_SIZE 65536    // TZif files are a few KB, anything bigger is not one
+#define TZIF_HEADER_SIZE 44
+#define SEC_PER_DAY 86400
+#define SEC_PER_HOUR 3600
+#define SEC_PER_MIN 60
+/* Private macros ------------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    char name[WORLD_ZONE_NAME_SIZE];
+    character_t label[WORLD_LABEL_CHARS];
+    uint32_t first;     // First transition of the zone's table in the pool
+    uint32_t count;     // Number of transitions in the table
+} world_zone_t;
+
+// Transition tables of all zones, stored back to back. Offset i is in effect from
+// transitionStarts[i] until the next transition of the same table.
+typedef struct {
+    int64_t *starts;
+    int32_t *offsets;
+    uint32_t used;
+    uint32_t size;
+} transition_pool_t;
+
+// Day of the year a POSIX TZ rule changes on
+typedef enum {
+    RULE_JULIAN = 0,    // Jn: day 1 to 365, February 29th is never counted
+    RULE_DAY,           // n: day 0 to 365, February 29th is counted
+    RULE_MONTH_WEEK     // Mm.w.d: day d (0 is Sunday) of week w (5 is the last) of month m
+} rule_kind_t;
+
+typedef struct {
+    rule_kind_t kind;
+    int32_t day;
+    int32_t week;
+    int32_t month;
+    int32_t timeSec;    // Local time of day the change happens at, may be negative or past 24h
+} tz_rule_date_t;
+
+// The POSIX TZ string at the end of a TZif file, for times after its last transition
+typedef struct {
+    bool isValid;
+    bool hasDst;
+    int32_t stdOffset;  // UTC offsets, east positive
+    int32_t dstOffset;
+    tz_rule_date_t start;   // Change to daylight saving time, in standard time
+    tz_rule_date_t end;     // Change back, in daylight saving time
+} tz_rule_t;
+
+// Transitions of a zone file (the 64-bit block of version 2+ files)
+typedef struct {
+    const uint8_t *times;   // timeCount big-endian transition times
+    const uint8_t *types;   // timeCount indexes into the local time types
+    const uint8_t *infos;   // typeCount local time types (6 bytes each, the offset first)
+    uint32_t timeCount;
+    uint32_t typeCount;
+    uint8_t timeSize;       // 4 or 8 bytes per transition time
+    tz_rule_t rule;
+} tz_file_t;
+
+/* Private variables ---------------------------------------------------------*/
+static world_zone_t zones[WORLD_CLOCK_MAX_ZONES];
+static uint16_t zoneCount = 0;
+static uint16_t tableCount = 0;
+static transition_pool_t pool = {0};
+static time_t horizonEnd = 0;   // The tables are good until here, the earliest of all loads
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Appends a transition to the pool, growing it when needed.
+ *
+ * @return led_matrix_err_t - LED_IO_ERROR if out of memory.
+ */
+static led_matrix_err_t appendTransition(int64_t start, int32_t offset);
+
+/**
+ * @brief Reads a big-endian signed integer of 4 or 8 bytes.
+ *
+ */
+static int64_t readBigEndian(const uint8_t *bytes, uint8_t size);
+
+/**
+ * @brief Parses a POSIX TZ offset, [+|-]hh[:mm[:ss]].
+ *
+ * @param text - Parsed from here, advanced past the offset
+ * @param secOut - Offset in seconds
+ * @return bool - false if there is no valid offset
+ */
+static bool parseRuleTime(const char **text, int32_t *secOut);
+
+/**
+ * @brief Parses a POSIX TZ string, e.g. "EST5EDT,M3.2.0,M11.1.0" or "<+1030>-10:30<+11>-11,M10.1.0,M4.1.0".
+ *
+ * @param text - TZ string
+ * @param rule - Parsed rule, isValid is false if the string is empty or not understood
+ */
+static void parseRule(const char *text, tz_rule_t *rule);
+
+/**
+ * @brief Returns the UTC time a rule changes on in a year.
+ *
+ * @param date - Day and time of the change
+ * @param year
+ * @param offset - UTC offset in effect before the change
+ */
+static int64_t getRuleChange(const tz_rule_date_t *date, int64_t year, int32_t offset);
+
+/**
+ * @brief Returns the UTC offset a rule gives at a time.
+ *
+ */
+static int32_t getRuleOffsetAt(const tz_rule_t *rule, int64_t t);
+
+/**
+ * @brief Returns the first change of a rule after a time.
+ *
+ */
+static int64_t getRuleNextChange(const tz_rule_t *rule, int64_t t);
+
+/**
+ * @brief Parses a TZif zone file.
+ *
+ * @param data - File contents
+ * @param size - File size
+ * @param file - Parsed file, points into data
+ * @return led_matrix_err_t - LED_IO_ERROR if it is not a TZif file this can read.
+ */
+static led_matrix_err_t parseZoneFile(const uint8_t *data, size_t size, tz_file_t *file);
+
+/**
+ * @brief Builds the transition table of a zone file at the end of the pool. Every transition 
+ *        of the file is used, and the TZ string at its end after the last one.
+ *
+ * @param file - Parsed zone file
+ * @param from - Start of the table
+ * @param to - End of the table
+ * @return led_matrix_err_t - Status of the operation.
+ */
+static led_matrix_err_t buildTable(const tz_file_t *file, time_t from, time_t to);
+
+/**
+ * @brief Reads the zone file of a zone and builds its table at the end of the pool, or shares 
+ *        the table of an earlier zone with the same transitions.
+ *
+ * @param zone - Zone index, its name must be set
+ * @param from - Start of the table
+ * @return led_matrix_err_t - Status of the operation, the pool is left as it was on errors.
+ */
+static led_matrix_err_t loadTable(uint16_t zone, time_t from);
+
+/**
+ * @brief Adds a single zone.
+ *
+ * @param name - Timezone name
+ * @param label - Label, or NULL to derive it from the name
+ * @param from - Start of the transition table
+ * @return led_matrix_err_t - Status of the operation.
+ */
+static led_matrix_err_t addZone(const char *name, const char *label, time_t from);
+
+/* Definitions ---------------------------------------------------------------*/
+static led_matrix_err_t appendTransition(int64_t start, int32_t offset)
+{
+    if(pool.used == pool.size) {
+        uint32_t newSize = pool.size == 0 ? 256 : pool.size * 2;
+        int64_t *starts = realloc(pool.starts, newSize * sizeof(int64_t));
+        if(starts == NULL) {
+            return LED_IO_ERROR;
+        }
+        pool.starts = starts;
+        int32_t *offsets = realloc(pool.offsets, newSize * sizeof(int32_t));
+        if(offsets == NULL) {
+            return LED_IO_ERROR;
+        }
+        pool.offsets = offsets;
+        pool.size = newSize;
+    }
+    pool.starts[pool.used] = start;
+    pool.offsets[pool.used] = offset;
+    pool.used++;
+    return LED_OK;
+}
+
+static int64_t readBigEndian(const uint8_t *bytes, uint8_t size)
+{
+    uint64_t value = 0;
+
+    for(uint8_t i = 0; i < size; i++) {
+        value = (value << 8) | bytes[i];
+    }
+    // Sign extend 4 byte values
+    if(size == 4) {
+        return (int64_t)(int32_t)(uint32_t)value;
+    }
+    return (int64_t)value;
+}
+
+static bool parseRuleTime(const char **text, int32_t *secOut)
+{
+    const char *p = *text;
+    int32_t sign = 1;
+    int32_t parts[3] = {0};
+
+    if(*p == '+' || *p == '-') {
+        sign = (*p == '-') ? -1 : 1;
+        p++;
+    }
+    for(uint8_t i = 0; i < 3; i++) {
+        if(i > 0) {
+            if(*p != ':') {
+                break;
+            }
+            p++;
+        }
+        if(!isdigit((unsigned char)*p)) {
+            return false;
+        }
+        while(isdigit((unsigned char)*p)) {
+            parts[i] = parts[i] * 10 + (*p++ - '0');
+            if(parts[i] > 167) {
+                return false;
+            }
+        }
+    }
+    *secOut = sign * (parts[0] * SEC_PER_HOUR + parts[1] * SEC_PER_MIN + parts[2]);
+    *text = p;
+    return true;
+}
+
+static void parseRule(const char *text, tz_rule_t *rule)
+{
+    const char *p = text;
+    int32_t stdSec = 0, dstSec = 0;
+    tz_rule_date_t *dates[2] = {&rule->start, &rule->end};
+
+    memset(rule, 0, sizeof(tz_rule_t));
+    for(uint8_t name = 0; name < 2; name++) {
+        // Zone abbreviation, letters or anything quoted in <>
+        const char *nameStart = p;
+        if(*p == '<') {
+            p = strchr(p, '>');
+            if(p == NULL) {
+                return;
+            }
+            p++;
+        } else {
+            while(isalpha((unsigned char)*p)) {
+                p++;
+            }
+        }
+        if(p == nameStart) {
+            if(name == 0) {
+                return;
+            }
+            break;
+        }
+        rule->hasDst = (name == 1);
+
+        // POSIX offsets are west positive. Daylight saving time is an hour ahead without one.
+        if(name == 0 && !parseRuleTime(&p, &stdSec)) {
+            return;
+        }
+        if(name == 1 && (*p == ',' || *p == '\0')) {
+            dstSec = stdSec - SEC_PER_HOUR;
+        } else if(name == 1 && !parseRuleTime(&p, &dstSec)) {
+            return;
+        }
+    }
+    rule->stdOffset = -stdSec;
+    rule->dstOffset = -dstSec;
+
+    if(rule->hasDst) {
+        // Without rules use the US ones, like the C library
+        if(*p == '\0') {
+            p = ",M3.2.0,M11.1.0";
+        }
+        for(uint8_t i = 0; i < 2; i++) {
+            tz_rule_date_t *date = dates[i];
+            char *endPtr = NULL;
+
+            if(*p++ != ',') {
+                return;
+            }
+            if(*p == 'M') {
+                date->kind = RULE_MONTH_WEEK;
+                date->month = (int32_t)strtol(p + 1, &endPtr, 10);
+                if(*endPtr != '.') {
+                    return;
+                }
+                date->week = (int32_t)strtol(endPtr + 1, &endPtr, 10);
+                if(*endPtr != '.') {
+                    return;
+                }
+                date->day = (int32_t)strtol(endPtr + 1, &endPtr, 10);
+                if(date->month < 1 || date->month > 12 || date->week < 1 || date->week > 5 || date->day < 0 || date->day > 6) {
+                    return;
+                }
+            } else if(*p == 'J') {
+                date->kind = RULE_JULIAN;
+                date->day = (int32_t)strtol(p + 1, &endPtr, 10);
+                if(date->day < 1 || date->day > 365) {
+                    return;
+                }
+            } else if(isdigit((unsigned char)*p)) {
+                date->kind = RULE_DAY;
+                date->day = (int32_t)strtol(p, &endPtr, 10);
+                if(date->day > 365) {
+                    return;
+                }
+            } else {
+                return;
+            }
+            p = endPtr;
+            date->timeSec = 2 * SEC_PER_HOUR;
+            if(*p == '/') {
+                p++;
+                if(!parseRuleTime(&p, &date->timeSec)) {
+                    return;
+                }
+            }
+        }
+    }
+    rule->isValid = (*p == '\0');
+}
+
+static int64_t getRuleChange(const tz_rule_date_t *date, int64_t year, int32_t offset)
+{
+    static const uint8_t monthDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool isLeap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    // Days from the epoch to January 1st of the year (civil from days, proleptic Gregorian)
+    int64_t y = year - 1;
+    int64_t days = 365 * (y - 1969) + (y / 4 - 1969 / 4) - (y / 100 - 1969 / 100) + (y / 400 - 1969 / 400);
+    int64_t yearDay = 0;
+
+    switch(date->kind) {
+        case RULE_JULIAN:
+            yearDay = date->day - 1 + (isLeap && date->day >= 60);
+            break;
+        case RULE_DAY:
+            yearDay = date->day;
+            break;
+        default: {
+            uint8_t monthLength = monthDays[date->month - 1] + (isLeap && date->month == 2);
+            for(int32_t m = 1; m < date->month; m++) {
+                yearDay += monthDays[m - 1] + (isLeap && m == 2);
+            }
+            // January 1st 1970 was a Thursday
+            int64_t firstWeekday = ((days + yearDay + 4) % 7 + 7) % 7;
+            int64_t monthDay = (date->day - firstWeekday + 7) % 7 + (date->week - 1) * 7;
+            if(monthDay >= monthLength) {
+                monthDay -= 7;
+            }
+            yearDay += monthDay;
+            break;
+        }
+    }
+    return (days + yearDay) * SEC_PER_DAY + date->timeSec - offset;
+}
+
+static int32_t getRuleOffsetAt(const tz_rule_t *rule, int64_t t)
+{
+    int64_t year = 1970 + (t >= 0 ? t : t - 365LL * SEC_PER_DAY) / (int64_t)(365.2425 * SEC_PER_DAY);
+    int64_t latest = INT64_MIN;
+    int32_t offset = rule->stdOffset;
+
+    if(!rule->hasDst) {
+        return rule->stdOffset;
+    }
+    // The year estimate may be off by one, the change before t is in one of these years
+    for(int64_t y = year - 2; y <= year + 1; y++) {
+        int64_t start = getRuleChange(&rule->start, y, rule->stdOffset);
+        int64_t end = getRuleChange(&rule->end, y, rule->dstOffset);
+        if(start <= t && start > latest) {
+            latest = start;
+            offset = rule->dstOffset;
+        }
+        if(end <= t && end > latest) {
+            latest = end;
+            offset = rule->stdOffset;
+        }
+    }
+    return offset;
+}
+
+static int64_t getRuleNextChange(const tz_rule_t *rule, int64_t t)
+{
+    int64_t year = 1970 + (t >= 0 ? t : t - 365LL * SEC_PER_DAY) / (int64_t)(365.2425 * SEC_PER_DAY);
+    int64_t next = INT64_MAX;
+
+    if(!rule->hasDst) {
+        return INT64_MAX;
+    }
+    for(int64_t y = year - 1; y <= year + 2; y++) {
+        int64_t start = getRuleChange(&rule->start, y, rule->stdOffset);
+        int64_t end = getRuleChange(&rule->end, y, rule->dstOffset);
+        if(start > t && start < next) {
+            next = start;
+        }
+        if(end > t && end < next) {
+            next = end;
+        }
+    }
+    return next;
+}
+
+static led_matrix_err_t parseZoneFile(const uint8_t *data, size_t size, tz_file_t *file)
+{
+    led_matrix_err_t status = LED_OK;
+    size_t offset = 0;
+
+    memset(file, 0, sizeof(tz_file_t));
+    file->timeSize = 4;
+    do {
+        if(size < TZIF_HEADER_SIZE || memcmp(data, "TZif", 4) != 0) {
+            status = LED_IO_ERROR;
+            break;
+        }
+
+        // Version 2+ files repeat the data with 64-bit times after the 32-bit block, then the TZ string
+        for(uint8_t block = 0; block < 2; block++) {
+            const uint8_t *header = data + offset;
+            uint32_t utcCount = (uint32_t)readBigEndian(header + 20, 4);
+            uint32_t stdCount = (uint32_t)readBigEndian(header + 24, 4);
+            uint32_t leapCount = (uint32_t)readBigEndian(header + 28, 4);
+            uint32_t timeCount = (uint32_t)readBigEndian(header + 32, 4);
+            uint32_t typeCount = (uint32_t)readBigEndian(header + 36, 4);
+            uint32_t charCount = (uint32_t)readBigEndian(header + 40, 4);
+            size_t blockSize = (size_t)timeCount * (file->timeSize + 1) + (size_t)typeCount * 6 + charCount +
+                               (size_t)leapCount * (file->timeSize + 4) + stdCount + utcCount;
+
+            // Leap second ("right/") zones count time differently, they are not supported
+            if(offset + TZIF_HEADER_SIZE + blockSize > size || typeCount == 0 || leapCount != 0) {
+                status = LED_IO_ERROR;
+                break;
+            }
+            file->times = header + TZIF_HEADER_SIZE;
+            file->types = file->times + (size_t)timeCount * file->timeSize;
+            file->infos = file->types + timeCount;
+            file->timeCount = timeCount;
+            file->typeCount = typeCount;
+            for(uint32_t i = 0; i < timeCount; i++) {
+                if(file->types[i] >= typeCount) {
+                    status = LED_IO_ERROR;
+                }
+            }
+            offset += TZIF_HEADER_SIZE + blockSize;
+            if(status != LED_OK || data[4] < '2' || block == 1) {
+                break;
+            }
+            if(offset + TZIF_HEADER_SIZE > size || memcmp(data + offset, "TZif", 4) != 0) {
+                status = LED_IO_ERROR;
+                break;
+            }
+            file->timeSize = 8;
+        }
+        if(status != LED_OK) {
+            break;
+        }
+
+        // TZ string between newlines for times after the last transition
+        if(file->timeSize == 8 && offset < size && data[offset] == '\n') {
+            char tz[128];
+            const uint8_t *end = memchr(data + offset + 1, '\n', size - offset - 1);
+            size_t length = end != NULL ? (size_t)(end - (data + offset + 1)) : 0;
+            if(end != NULL && length > 0 && length < sizeof(tz)) {
+                memcpy(tz, data + offset + 1, length);
+                tz[length] = '\0';
+                parseRule(tz, &file->rule);
+            }
+        }
+    } while(0);
+    return status;
+}
+
+static led_matrix_err_t buildTable(const tz_file_t *file, time_t from, time_t to)
+{
+    led_matrix_err_t status = LED_OK;
+    // Times before the first transition use the first local time type
+    int32_t offset = (int32_t)readBigEndian(file->infos, 4);
+    int64_t lastTransition = INT64_MIN;
+    uint32_t i = 0;
+
+    // Offset in effect at from
+    for(; i < file->timeCount && readBigEndian(&file->times[i * file->timeSize], file->timeSize) <= (int64_t)from; i++) {
+        offset = (int32_t)readBigEndian(&file->infos[file->types[i] * 6], 4);
+    }
+    if(file->timeCount > 0) {
+        lastTransition = readBigEndian(&file->times[(file->timeCount - 1) * file->timeSize], file->timeSize);
+    }
+    if(file->rule.isValid && (int64_t)from >= lastTransition) {
+        offset = getRuleOffsetAt(&file->rule, from);
+    }
+    status = appendTransition(from, offset);
+
+    // Every transition of the file up to the end, skipping those that only change the name or DST flag
+    for(; i < file->timeCount && status == LED_OK; i++) {
+        int64_t start = readBigEndian(&file->times[i * file->timeSize], file->timeSize);
+        int32_t next = (int32_t)readBigEndian(&file->infos[file->types[i] * 6], 4);
+        if(start > (int64_t)to) {
+            break;
+        }
+        if(next != offset) {
+            offset = next;
+            status = appendTransition(start, offset);
+        }
+    }
+
+    // Then the changes of the TZ string
+    if(file->rule.isValid) {
+        int64_t t = lastTransition > (int64_t)from ? lastTransition : (int64_t)from;
+        for(t = getRuleNextChange(&file->rule, t); t <= (int64_t)to && status == LED_OK; t = getRuleNextChange(&file->rule, t)) {
+            int32_t next = getRuleOffsetAt(&file->rule, t);
+            if(next != offset) {
+                offset = next;
+                status = appendTransition(t, offset);
+            }
+        }
+    }
+    return status;
+}
+
+static led_matrix_err_t loadTable(uint16_t zone, time_t from)
+{
+    world_zone_t *entry = &zones[zone];
+    char path[sizeof(ZONEINFO_DIR) + WORLD_ZONE_NAME_SIZE];
+    uint32_t first = pool.used;
+    uint8_t *data = NULL;
+    size_t size = 0;
+    tz_file_t file;
+    FILE *zoneFile = NULL;
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        snprintf(path, sizeof(path), "%s/%s", ZONEINFO_DIR, entry->name);
+        zoneFile = fopen(path, "rb");
+        if(zoneFile == NULL) {
+            printf("Unknown timezone: %s\n", entry->name);
+            status = LED_ARG_ERROR;
+            break;
+        }
+        data = malloc(ZONE_FILE_MAX_SIZE);
+        if(data == NULL) {
+            status = LED_IO_ERROR;
+            break;
+        }
+        size = fread(data, 1, ZONE_FILE_MAX_SIZE, zoneFile);
+        if(parseZoneFile(data, size, &file) != LED_OK) {
+            printf("Unsupported timezone file: %s\n", path);
+            status = LED_ARG_ERROR;
+            break;
+        }
+        status = buildTable(&file, from, from + (time_t)WORLD_CLOCK_HORIZON_DAYS * SEC_PER_DAY);
+        if(status != LED_OK) {
+            printf("Could not allocate transition table for %s\n", entry->name);
+            pool.used = first;
+            break;
+        }
+
+        // Share the table of a zone with the same transitions (e.g. most of Europe)
+        entry->first = first;
+        entry->count = pool.used - first;
+        for(uint16_t i = 0; i < zone; i++) {
+            if(zones[i].count == entry->count &&
+               memcmp(&pool.starts[zones[i].first], &pool.starts[first], entry->count * sizeof(int64_t)) == 0 &&
+               memcmp(&pool.offsets[zones[i].first], &pool.offsets[first], entry->count * sizeof(int32_t)) == 0) {
+                entry->first = zones[i].first;
+                pool.used = first;
+                break;
+            }
+        }
+        if(entry->first == first) {
+            tableCount++;
+        }
+    } while(0);
+
+    if(zoneFile != NULL) {
+        fclose(zoneFile);
+    }
+    free(data);
+    return status;
+}
+
+static led_matrix_err_t addZone(const char *name, const char *label, time_t from)
+{
+    world_zone_t *zone = &zones[zoneCount];
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(zoneCount >= WORLD_CLOCK_MAX_ZONES || strlen(name) == 0 || strlen(name) >= WORLD_ZONE_NAME_SIZE) {
+            printf("Invalid argument: zone=%s, zones loaded=%u\n", name, zoneCount);
+            status = LED_ARG_ERROR;
+            break;
+        }
+        // The name is a path below ZONEINFO_DIR, it must not lead out of it
+        if(name[0] == '/' || strstr(name, "..") != NULL) {
+            printf("Invalid argument: zone=%s is not a zone name\n", name);
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        snprintf(zone->name, sizeof(zone->name), "%s", name);
+        status = loadTable(zoneCount, from);
+        if(status != LED_OK) {
+            break;
+        }
+
+        // Without a label use the city, the part after the last '/'
+        if(label == NULL) {
+            label = strrchr(name, '/') != NULL ? strrchr(name, '/') + 1 : name;
+        }
+        for(uint8_t i = 0, j = 0; i < WORLD_LABEL_CHARS; i++) {
+            // Skip separators like '_' in derived labels, stop at the end of the label
+            while(label[j] != '\0' && !isalpha((unsigned char)label[j]) && label[j] != ' ') {
+                j++;
+            }
+            if(label[j] == '\0' || label[j] == ' ') {
+                zone->label[i] = NUM_CHARACTERS;
+                j += (label[j] == ' ');
+            } else {
+                zone->label[i] = (character_t)(A_CHAR + (toupper((unsigned char)label[j]) - 'A'));
+                j++;
+            }
+        }
+
+        zoneCount++;
+    } while(0);
+    return status;
+}
+
+led_matrix_err_t worldClockLoadZones(const char *zoneList)
+{
+    char list[WORLD_CLOCK_MAX_ZONES * 8];
+    char *next = NULL;
+    time_t from = time(NULL) - SEC_PER_DAY;
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(zoneList == NULL || strlen(zoneList) >= sizeof(list)) {
+            printf("Invalid zone list\n");
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        snprintf(list, sizeof(list), "%s", zoneList);
+
+        for(char *entry = strtok_r(list, ",", &next); entry != NULL && status == LED_OK; entry = strtok_r(NULL, ",", &next)) {
+            char *label = strchr(entry, '=');
+            if(label != NULL) {
+                *label++ = '\0';
+            }
+            status = addZone(entry, label, from);
+        }
+
+        if(status == LED_OK && (horizonEnd == 0 || from + (time_t)WORLD_CLOCK_HORIZON_DAYS * SEC_PER_DAY < horizonEnd)) {
+            horizonEnd = from + (time_t)WORLD_CLOCK_HORIZON_DAYS * SEC_PER_DAY;
+        }
+    } while(0);
+    return status;
+}
+
+led_matrix_err_t worldClockRefresh(time_t now)
+{
+    static world_zone_t oldZones[WORLD_CLOCK_MAX_ZONES]; // Too big for the stack of the render loop
+    transition_pool_t oldPool = pool;
+    uint16_t oldTableCount = tableCount;
+    time_t from = now - SEC_PER_DAY;
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(zoneCount == 0 || now + (time_t)WORLD_CLOCK_REFRESH_DAYS * SEC_PER_DAY < horizonEnd) {
+            break;
+        }
+
+        // Build all the tables again in a new pool, keeping the old ones if that fails
+        memcpy(oldZones, zones, zoneCount * sizeof(world_zone_t));
+        memset(&pool, 0, sizeof(pool));
+        tableCount = 0;
+        for(uint16_t i = 0; i < zoneCount && status == LED_OK; i++) {
+            status = loadTable(i, from);
+        }
+        if(status != LED_OK) {
+            free(pool.starts);
+            free(pool.offsets);
+            pool = oldPool;
+            tableCount = oldTableCount;
+            memcpy(zones, oldZones, zoneCount * sizeof(world_zone_t));
+            break;
+        }
+        free(oldPool.starts);
+        free(oldPool.offsets);
+        horizonEnd = from + (time_t)WORLD_CLOCK_HORIZON_DAYS * SEC_PER_DAY;
+    } while(0);
+    return status;
+}
+
+void worldClockClear(void)
+{
+    free(pool.starts);
+    free(pool.offsets);
+    memset(&pool, 0, sizeof(pool));
+    zoneCount = 0;
+    tableCount = 0;
+    horizonEnd = 0;
+}
+
+uint16_t worldClockGetZoneCount(void)
+{
+    return zoneCount;
+}
+
+uint16_t worldClockGetTableCount(void)
+{
+    return tableCount;
+}
+
+led_matrix_err_t worldClockGetTime(uint16_t zone, time_t utc, world_time_t *timeOut)
+{
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(zone >= zoneCount || timeOut == NULL) {
+            printf("Invalid argument: zone=%u\n", zone);
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        // Last transition at or before utc. Times before the table use its first offset.
+        const int64_t *starts = &pool.starts[zones[zone].first];
+        uint32_t lo = 0, hi = zones[zone].count;
+        while(hi - lo > 1) {
+            uint32_t mid = (lo + hi) / 2;
+            if(starts[mid] <= (int64_t)utc) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+
+        int32_t offset = pool.offsets[zones[zone].first + lo];
+        int64_t secOfDay = ((int64_t)utc + offset) % SEC_PER_DAY;
+        if(secOfDay < 0) {
+            secOfDay += SEC_PER_DAY;
+        }
+        timeOut->hour = (uint8_t)(secOfDay / SEC_PER_HOUR);
+        timeOut->minute = (uint8_t)((secOfDay % SEC_PER_HOUR) / SEC_PER_MIN);
+        timeOut->utcOffsetSec = offset;
+    } while(0);
+    return status;
+}
+
+led_matrix_err_t worldClockGetLabel(uint16_t zone, character_t labelOut[WORLD_LABEL_CHARS])
+{
+    led_matrix_err_t status = LED_OK;
+
+    do {
+        if(zone >= zoneCount || labelOut == NULL) {
+            printf("Invalid argument: zone=%u\n", zone);
+            status = LED_ARG_ERROR;
+            break;
+        }
+
+        memcpy(labelOut, zones[zone].label, sizeof(zones[zone].label));
+    } while(0);
+    return status;
+}
+
+const char *worldClockGetZoneName(uint16_t zone)
+{
+    if(zone >= zoneCount) {
+        return NULL;
+    }
+    return zones[zone].name;
+}
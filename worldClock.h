@@ -0,0 +1,106 @@
+/** ********************************************************************************
+*@file worldClock.h
+*@date March 5th, 2026
+*@author julio.liriano (julio.liriano@gmail.com)
+*@brief World clock engine. The UTC offset transitions of each configured timezone
+*       are read from its zone file into a table, after which the local time in any zone is a
+*       binary search plus an add, with no TZ changes or localtime_r() calls.
+*
+********************************************************************************** */
+#ifndef __WORLDCLOCK_H
+#define __WORLDCLOCK_H
+/* Includes ------------------------------------------------------------------*/
+#include "ledMatrix.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+/* Exported constants --------------------------------------------------------*/
+#define WORLD_CLOCK_MAX_ZONES 1024
+#define WORLD_ZONE_NAME_SIZE 64         // Timezone name (e.g. "America/New_York") including the terminator
+#define WORLD_LABEL_CHARS 4             // Label characters, one per digit position
+#define WORLD_CLOCK_HORIZON_DAYS 1461   // Transitions are loaded for this many days (4 years) from load time
+#define WORLD_CLOCK_REFRESH_DAYS 30     // worldClockRefresh() rebuilds the tables when the horizon is this close
+/* Exported macros -----------------------------------------------------------*/
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    uint8_t hour;           // 0-23
+    uint8_t minute;
+    int32_t utcOffsetSec;   // Offset from UTC in effect, including daylight saving time
+} world_time_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief Loads a comma separated list of zones, each an IANA timezone name with an optional
+ *        label, e.g. "America/New_York=NYC,Europe/London=LON,Asia/Tokyo". Without a label the
+ *        first letters of the city name are used. Zones whose offsets match an already loaded
+ *        zone share its table. The transitions are read from the zone files directly, so the
+ *        TZ environment variable is never touched.
+ *
+ * @param zoneList - Zones to add.
+ * @return led_matrix_err_t - LED_ARG_ERROR for an unknown zone, a name that is not a path
+ *                            inside the zone directory ("..", leading '/') or a full table,
+ *                            the zones before it stay loaded.
+ */
+led_matrix_err_t worldClockLoadZones(const char *zoneList);
+
+/**
+ * @brief Rebuilds the transition tables from the current time when the loaded horizon is less
+ *        than WORLD_CLOCK_REFRESH_DAYS away, otherwise does nothing. Cheap enough to call hourly.
+ *        Must not run while another thread calls worldClockGetTime().
+ *
+ * @param now - Current time in seconds since the epoch
+ * @return led_matrix_err_t - Status of the operation, the old tables are kept on errors.
+ */
+led_matrix_err_t worldClockRefresh(time_t now);
+
+/**
+ * @brief Removes all zones and frees the transition tables.
+ *
+ */
+void worldClockClear(void);
+
+/**
+ * @brief Returns the number of loaded zones.
+ *
+ * @return uint16_t
+ */
+uint16_t worldClockGetZoneCount(void);
+
+/**
+ * @brief Returns the number of distinct transition tables (zones with identical offsets share one).
+ *
+ * @return uint16_t
+ */
+uint16_t worldClockGetTableCount(void);
+
+/**
+ * @brief Gets the local time in a zone. Times past the loaded horizon use the last known offset.
+ *        Safe to call from any thread once the zones are loaded.
+ *
+ * @param zone - Zone index (0 to worldClockGetZoneCount() - 1)
+ * @param utc - Time in seconds since the epoch
+ * @param timeOut - Local time in the zone
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t worldClockGetTime(uint16_t zone, time_t utc, world_time_t *timeOut);
+
+/**
+ * @brief Gets the label of a zone as characters for the digit positions (POS1 to POS4).
+ *
+ * @param zone - Zone index
+ * @param labelOut - NUM_CHARACTERS marks a blank position.
+ * @return led_matrix_err_t - Status of the operation.
+ */
+led_matrix_err_t worldClockGetLabel(uint16_t zone, character_t labelOut[WORLD_LABEL_CHARS]);
+
+/**
+ * @brief Returns the timezone name of a zone, or NULL for an invalid index.
+ *
+ * @param zone - Zone index
+ * @return const char*
+ */
+const char *worldClockGetZoneName(uint16_t zone);
+#endif /* __WORLDCLOCK_H */